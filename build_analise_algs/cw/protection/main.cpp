@@ -1,15 +1,26 @@
-#include "rb_tree.h"
+#include "task_store.h"
+#include "snapshot.h"
+#include "binary_io.h"
 
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstdio>
+#include <algorithm>
 
-const std::string path = "./save.txt";
+#include <fcntl.h>
+#include <unistd.h>
+
+const std::string path = "./tasks";
+
+// Saves of the older versions: text with one "<priority> <text>" line per task, then a binary snapshot
+const std::string legacyTextPath = "./save.txt";
+const std::string legacySnapshotPath = "./save.bin";
 
 int command()
 {
     int n;
-    std::cout << "Input command(0 - exit, 1 - input, 2 - output, 3 - clear, 4 - save, 5 - load): ";
+    std::cout << "Input command(0 - exit, 1 - input, 2 - output, 3 - clear, 4 - checkpoint, 5 - recover): ";
     std::cin >> n;
     return n;
 }
@@ -31,66 +42,109 @@ void input(std::vector<Task>& vec)
     }
 }
 
-void save(RBTree& rb_tree)
+void checkpoint(TaskStore& store)
 {
-    std::ofstream out;
-    out.open(path);
-
-    std::vector<Task> vec;
+    if (!store.checkpoint()) {
+        std::cout << "Checkpoint failed" << std::endl;
+    }
+}
 
-    if (out.is_open()) {
-        rb_tree.getData(vec);
-        out << (int)vec.size() << "\n";
-        for (auto e: vec) {
-            out << e.key_ << " " << e.data_ << "\n";
-        }
+bool writeMarker(const std::string& markerPath, uint64_t sequence)
+{
+    int fd = open(markerPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
     }
-    out.close(); 
+
+    bool ok = writeAll(fd, std::to_string(sequence)) && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    syncParentDirectory(markerPath);
+
+    return ok;
 }
 
-void load(RBTree& rb_tree)
+// Moves the tasks of an old save into the store once, the save is renamed afterwards.
+// A marker keeps the log sequence from before the import, so after a crash the tasks
+// that already reached the log are skipped instead of imported twice
+void importLegacy(TaskStore& store, const std::string& legacyPath)
 {
-    int n;
-    rb_tree.clear();
+    std::vector<Task> vec;
+    std::string markerPath = legacyPath + ".importing";
 
-    std::ifstream in(path);
-    if (in.is_open()) {
+    std::ifstream in(legacyPath);
+    if (!in.is_open()) {
+        std::remove(markerPath.c_str());
+        return;
+    }
+
+    uint64_t start = 0;
+    std::ifstream marker(markerPath);
+    if (!(marker >> start)) {
+        start = store.sequence();
+        if (!writeMarker(markerPath, start)) {
+            std::cout << "Cannot import " << legacyPath << std::endl;
+            return;
+        }
+    }
+
+    if (legacyPath == legacyTextPath) {
+        int n = 0;
         in >> n;
 
         int key;
         std::string data;
-        for (int i = 0; i < n; i++) {
-            in >> key >> data;
-            rb_tree.insert(key, data);
+        for (int i = 0; i < n && in >> key >> data; i++) {
+            vec.push_back({key, data});
         }
+    } else {
+        RBTree tree;
+        if (!loadSnapshot(legacyPath, tree)) {
+            std::cout << "Cannot import " << legacyPath << std::endl;
+            return;
+        }
+        tree.getData(vec);
     }
-    in.close();
+
+    // Each task is one log record
+    uint64_t logged = store.sequence();
+    size_t imported = logged < start ? 0 : std::min<uint64_t>(logged - start, vec.size());
+    store.insert(std::vector<Task>(vec.begin() + imported, vec.end()));
+    if (!store.sync() || std::rename(legacyPath.c_str(), (legacyPath + ".imported").c_str()) != 0) {
+        std::cout << "Cannot import " << legacyPath << std::endl;
+        return;
+    }
+    std::remove(markerPath.c_str());
+
+    std::cout << "Imported " << vec.size() - imported << " tasks from " << legacyPath << std::endl;
 }
 
 int main()
 {
-    int n = command();
-
-    RBTree rb_tree;
+    TaskStore store(path);
     std::vector<Task> vec;
 
+    importLegacy(store, legacyTextPath);
+    importLegacy(store, legacySnapshotPath);
+
+    int n = command();
+
     while (n) {
         if (n == 1) {
             input(vec);
-            for (auto e: vec) {
-                rb_tree.insert(e.key_, e.data_);
-            }
+            store.insert(vec);
         } else if (n == 2) {
-            rb_tree.getData(vec);
+            store.getData(vec);
             for (auto e: vec) {
                 std::cout << e.key_ << " " << e.data_ << std::endl;
             }
         } else if (n == 3) {
-            rb_tree.clear();
+            store.clear();
         } else if (n == 4) {
-            save(rb_tree);
+            checkpoint(store);
         } else if (n == 5) {
-            load(rb_tree);
+            if (!store.recover()) {
+                std::cout << "Recover failed, unsaved tasks are kept" << std::endl;
+            }
         }
 
         n = command();
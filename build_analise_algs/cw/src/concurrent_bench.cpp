@@ -0,0 +1,105 @@
+#include "concurrent_rb_tree.h"
+#include "persistent_rb_tree.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+const int keysCount = 100000;
+const int opsPerThread = 200000;
+
+// Baseline: the whole tree behind one mutex, as callers had to do before
+class LockedRBTree
+{
+public:
+    void insert(int key, std::string data)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tree_.insert(key, std::move(data));
+    }
+
+    void remove(int key)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tree_.remove(key);
+    }
+
+    std::string find(int key)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const std::string* data = tree_.find(key);
+        return data == nullptr ? "" : *data;
+    }
+
+private:
+    RBTree tree_;
+    std::mutex mutex_;
+};
+
+// Every thread reads prefilled keys and writes only keys of its own, so no lookup misses
+template <typename Tree>
+double run(int threadsCount, int readPercent)
+{
+    Tree tree;
+    for (int i = 0; i < keysCount; i++) {
+        tree.insert(i * 2, "task");
+    }
+
+    auto worker = [&](int id) {
+        std::mt19937 rng(id);
+        int ownKey = keysCount * 2 + id * 2 + 1;
+        bool inserted = false;
+
+        for (int i = 0; i < opsPerThread; i++) {
+            if ((int)(rng() % 100) < readPercent) {
+                tree.find((int)(rng() % keysCount) * 2);
+            } else if (inserted) {
+                tree.remove(ownKey);
+                inserted = false;
+            } else {
+                tree.insert(ownKey, "task");
+                inserted = true;
+            }
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadsCount; i++) {
+        threads.emplace_back(worker, i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return threadsCount * (double)opsPerThread / elapsed.count();
+}
+
+int main()
+{
+    std::cout << std::setw(8) << "threads" << std::setw(8) << "reads"
+              << std::setw(16) << "mutex ops/s" << std::setw(16) << "rwlock ops/s" << std::setw(16) << "cow ops/s" << std::endl;
+
+    for (int threadsCount : {1, 2, 4, 8}) {
+        for (int readPercent : {50, 90, 99, 100}) {
+            double locked = run<LockedRBTree>(threadsCount, readPercent);
+            double shared = run<ConcurrentRBTree>(threadsCount, readPercent);
+            // Lock-free readers next to writers that copy their path
+            double persistent = run<PersistentRBTree>(threadsCount, readPercent);
+
+            std::cout << std::setw(8) << threadsCount << std::setw(7) << readPercent << "%"
+                      << std::setw(16) << (long long)locked << std::setw(16) << (long long)shared
+                      << std::setw(16) << (long long)persistent << std::endl;
+        }
+    }
+
+    return 0;
+}
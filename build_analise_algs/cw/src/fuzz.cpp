@@ -0,0 +1,289 @@
+#include "rb_tree.h"
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+Differential fuzzer: random operation sequences on RBTree and on a std::multimap
+model, compared and checked with verify() every 64 operations.
+Usage: ./fuzz [rounds] [first seed]
+*/
+
+using Model = std::multimap<int, std::string>;
+
+const int opsPerRound = 4000;
+
+unsigned long long currentSeed = 0;
+int currentOp = 0;
+
+void expect(bool condition, const char* what)
+{
+    if (!condition) {
+        std::cout << "Mismatch in " << what << ", seed " << currentSeed << ", operation " << currentOp << std::endl;
+        std::exit(1);
+    }
+}
+
+// Inserts like the tree does: after the equal keys, or over them under UNIQUE
+void modelInsert(Model& model, DuplicatePolicy policy, int key, const std::string& data)
+{
+    auto it = model.find(key);
+    if (policy == UNIQUE && it != model.end()) {
+        it->second = data;
+    } else {
+        model.insert(model.upper_bound(key), {key, data});
+    }
+}
+
+void compare(RBTree& tree, const Model& model)
+{
+    std::vector<Task> vec;
+    tree.getData(vec);
+    expect(vec.size() == model.size(), "size");
+
+    auto it = model.begin();
+    for (auto& e: vec) {
+        expect(e.key_ == it->first && e.data_ == it->second, "contents");
+        ++it;
+    }
+
+    expect(tree.verify(), "invariants");
+}
+
+// Seconds of a fake clock an hour ahead, so lazy eviction by the real clock never fires
+RBTree::TimePoint at(long long seconds)
+{
+    static const RBTree::TimePoint base = RBTree::Clock::now() + std::chrono::hours(1);
+    return base + std::chrono::seconds(seconds);
+}
+
+void round(unsigned long long seed)
+{
+    std::mt19937_64 rng(seed);
+    DuplicatePolicy policy = rng() % 2 ? MULTI : UNIQUE;
+    // Small key ranges produce long runs of equal keys, large ones deep trees
+    int range = (int)(rng() % 3 == 0 ? 16 : 1 + rng() % 5000);
+
+    RBTree tree(policy);
+    Model model;
+    // Deadlines by data, which is unique within a round; missing data never expires
+    std::map<std::string, long long> deadlines;
+    long long now = 0;
+    // Every other round runs with the hash index, which verify() checks too
+    tree.setHashIndex(seed % 2 == 0);
+
+    for (currentOp = 0; currentOp < opsPerRound; currentOp++) {
+        int key = (int)(rng() % range);
+        std::string data = std::to_string(currentOp);
+
+        switch (rng() % 18) {
+        case 0:
+        case 1:
+        case 2: {
+            tree.insert(key, data);
+            modelInsert(model, policy, key, data);
+            break;
+        }
+        case 3: {
+            auto it = model.find(key);
+            expect(tree.remove(key) == (it != model.end()), "remove");
+            if (it != model.end()) {
+                model.erase(it);
+            }
+            break;
+        }
+        case 4: {
+            expect(tree.eraseAll(key) == model.erase(key), "eraseAll");
+            break;
+        }
+        case 5: {
+            const std::string* found = tree.find(key);
+            auto it = model.find(key);
+            expect((found == nullptr) == (it == model.end()), "find");
+            expect(found == nullptr || *found == it->second, "find data");
+            expect(tree.contains(key) == (it != model.end()), "contains");
+            break;
+        }
+        case 6: {
+            std::vector<Task> equal;
+            tree.getEqual(key, equal);
+            auto equalRange = model.equal_range(key);
+            expect(tree.count(key) == model.count(key) && equal.size() == model.count(key), "count");
+            for (auto& e: equal) {
+                expect(e.data_ == equalRange.first->second, "getEqual");
+                ++equalRange.first;
+            }
+            break;
+        }
+        case 7: {
+            std::vector<Task> batch;
+            int size = rng() % 64;
+            for (int i = 0; i < size; i++) {
+                batch.push_back({(int)(rng() % range), data + "." + std::to_string(i)});
+            }
+
+            tree.insert(batch);
+            // The tree sorts the batch stably, so equal keys keep the batch order
+            std::stable_sort(batch.begin(), batch.end(), [](const Task& a, const Task& b) { return a.key_ < b.key_; });
+            for (auto& e: batch) {
+                modelInsert(model, policy, e.key_, e.data_);
+            }
+            break;
+        }
+        case 8: {
+            std::vector<int> keys;
+            int size = rng() % 16;
+            for (int i = 0; i < size; i++) {
+                keys.push_back((int)(rng() % range));
+            }
+
+            tree.remove(keys);
+            for (int e: keys) {
+                model.erase(e);
+            }
+            break;
+        }
+        case 9: {
+            Task top;
+            expect(tree.popMin(top) == !model.empty(), "popMin");
+            if (!model.empty()) {
+                expect(top.key_ == model.begin()->first && top.data_ == model.begin()->second, "popMin data");
+                model.erase(model.begin());
+            }
+            break;
+        }
+        case 10: {
+            Task top;
+            expect(tree.popMax(top) == !model.empty(), "popMax");
+            if (!model.empty()) {
+                auto last = std::prev(model.end());
+                expect(top.key_ == last->first && top.data_ == last->second, "popMax data");
+                model.erase(last);
+            }
+            break;
+        }
+        case 11: {
+            int newKey = (int)(rng() % range);
+            auto it = model.find(key);
+            expect(tree.changePriority(key, newKey) == (it != model.end()), "changePriority");
+            if (it != model.end()) {
+                std::string moved = it->second;
+                model.erase(it);
+                modelInsert(model, policy, newKey, moved);
+            }
+            break;
+        }
+        case 12: {
+            RBTree other;
+            other.setHashIndex(tree.hasHashIndex());
+            tree.split(key, other);
+            expect(other.verify(), "split index");
+            std::vector<Task> right;
+            other.getData(right);
+            expect(right.empty() || right.front().key_ >= key, "split");
+            expect(tree.maxKey() == nullptr || *tree.maxKey() < key, "split bounds");
+            tree.join(other);
+            break;
+        }
+        case 13: {
+            // A MULTI tree may repeat keys, which a UNIQUE one has to collapse
+            RBTree other(rng() % 2 ? MULTI : policy);
+            int size = rng() % 32;
+            for (int i = 0; i < size; i++) {
+                int otherKey = (int)(rng() % range);
+                std::string otherData = data + "+" + std::to_string(i);
+                if (i % 2 == 0) {
+                    other.insert(otherKey, otherData);
+                } else {
+                    deadlines[otherData] = now + (long long)(rng() % 200);
+                    other.insert(otherKey, otherData, at(deadlines[otherData]));
+                }
+            }
+
+            std::vector<Task> added;
+            other.getData(added);
+            tree.unite(other);
+            for (auto& e: added) {
+                modelInsert(model, policy, e.key_, e.data_);
+            }
+            break;
+        }
+        case 14: {
+            RBTree other;
+            other.insert(key, "");
+            other.insert((int)(rng() % range), "");
+            std::vector<Task> removed;
+            other.getData(removed);
+
+            tree.subtract(other);
+            for (auto& e: removed) {
+                model.erase(e.key_);
+            }
+            break;
+        }
+        case 15: {
+            if (!model.empty()) {
+                expect(*tree.minKey() == model.begin()->first && *tree.min() == model.begin()->second, "min");
+                expect(*tree.maxKey() == std::prev(model.end())->first && *tree.max() == std::prev(model.end())->second, "max");
+            } else {
+                expect(tree.min() == nullptr && tree.max() == nullptr, "empty bounds");
+            }
+            break;
+        }
+        case 16: {
+            deadlines[data] = now + (long long)(rng() % 200);
+            tree.insert(key, data, at(deadlines[data]));
+            modelInsert(model, policy, key, data);
+            break;
+        }
+        case 17: {
+            now += rng() % 50;
+            size_t expired = 0;
+            for (auto it = model.begin(); it != model.end();) {
+                auto deadline = deadlines.find(it->second);
+                if (deadline != deadlines.end() && deadline->second <= now) {
+                    it = model.erase(it);
+                    expired++;
+                } else {
+                    ++it;
+                }
+            }
+            expect(tree.evictExpired(at(now)) == expired, "evictExpired");
+            break;
+        }
+        }
+
+        if (currentOp % 64 == 0) {
+            compare(tree, model);
+        }
+    }
+
+    compare(tree, model);
+
+    std::vector<Task> vec;
+    tree.getData(vec);
+    tree.buildFromSorted(vec);
+    compare(tree, model);
+}
+
+int main(int argc, char** argv)
+{
+    int rounds = argc > 1 ? std::atoi(argv[1]) : 50;
+    unsigned long long firstSeed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+
+    for (int i = 0; i < rounds; i++) {
+        currentSeed = firstSeed + i;
+        round(currentSeed);
+    }
+
+    std::cout << "Fuzzing passed: " << rounds << " rounds" << std::endl;
+
+    return 0;
+}
\ No newline at end of file
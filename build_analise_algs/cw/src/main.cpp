@@ -25,7 +25,7 @@ int main()
     rb_tree.remove(3);
     rb_tree.print();
 
-    std::cout << "Task 7: " << rb_tree.find(7) << std::endl;
+    std::cout << "Task 7: " << *rb_tree.find(7) << std::endl;
 
     std::vector<Task> vec;
     rb_tree.getData(vec);
@@ -0,0 +1,69 @@
+#include "binary_io.h"
+
+#include <array>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+uint32_t crc32(const unsigned char* data, size_t size, uint32_t previous)
+{
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> res {};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+            }
+            res[i] = value;
+        }
+        return res;
+    }();
+
+    uint32_t crc = previous ^ 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void putUint(std::string& out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        out.push_back((char)((value >> (8 * i)) & 0xFF));
+    }
+}
+
+uint64_t getUint(const unsigned char* in, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)in[i] << (8 * i);
+    }
+
+    return value;
+}
+
+bool writeAll(int fd, const std::string& data)
+{
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t res = write(fd, data.data() + written, data.size() - written);
+        if (res < 0) {
+            return false;
+        }
+        written += res;
+    }
+
+    return true;
+}
+
+void syncParentDirectory(const std::string& path)
+{
+    std::string dir = path.find('/') == std::string::npos ? "." : path.substr(0, path.rfind('/') + 1);
+    int fd = open(dir.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
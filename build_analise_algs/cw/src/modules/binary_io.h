@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Little-endian encoding and file helpers shared by the snapshot and the write-ahead log
+
+// Pass the CRC of the preceding bytes as previous to extend it over data
+uint32_t crc32(const unsigned char* data, size_t size, uint32_t previous = 0);
+
+void putUint(std::string& out, uint64_t value, int bytes);
+uint64_t getUint(const unsigned char* in, int bytes);
+
+bool writeAll(int fd, const std::string& data);
+
+// Makes a rename or unlink inside the directory of path durable
+void syncParentDirectory(const std::string& path);
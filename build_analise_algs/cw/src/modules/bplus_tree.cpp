@@ -0,0 +1,3 @@
+#include "bplus_tree.h"
+
+template class BasicBPlusTree<int, std::string>;
\ No newline at end of file
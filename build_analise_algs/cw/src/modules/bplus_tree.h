@@ -0,0 +1,110 @@
+#pragma once
+
+#include "rb_tree.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+
+/*
+B+-tree with the interface of RBTree
+- Order -- maximum number of keys in a node; keys of a node are stored contiguously
+  and searched with a binary search, so a lookup touches about log_Order(n) nodes
+- tasks live in the leaves, which are linked in key order for scans
+- equal keys are allowed, a new task goes after the equal ones
+*/
+template <typename Key, typename Value, typename Compare = std::less<Key>, int Order = 64>
+class BasicBPlusTree
+{
+    static_assert(Order >= 4, "B+-tree order must be at least 4");
+
+public:
+    using Entry = BasicTask<Key, Value>;
+
+    explicit BasicBPlusTree(const Compare& compare = Compare());
+    ~BasicBPlusTree();
+
+    BasicBPlusTree(const BasicBPlusTree&) = delete;
+    BasicBPlusTree& operator=(const BasicBPlusTree&) = delete;
+
+    void insert(Key key, Value data);
+    void insert(const std::vector<Entry>& tasks);
+
+    // False if the key is missing
+    bool remove(const Key& key);
+
+    // Returns nullptr if the key is missing
+    Value* find(const Key& key);
+    const Value* find(const Key& key) const;
+
+    bool contains(const Key& key) const;
+    // Copies the data into out, reusing its storage, false if the key is missing
+    bool tryGet(const Key& key, Value& out) const;
+
+    void print();
+
+    void getData(std::vector<Entry>& res);
+
+    // Replaces the contents with tasks, which must be sorted by key, in O(n)
+    void buildFromSorted(const std::vector<Entry>& tasks);
+    template <typename It>
+    void buildFromSorted(It first, It last);
+
+    void clear();
+
+private:
+    struct Node
+    {
+        bool leaf_;
+        int count_;
+        Key keys_[Order];
+
+        explicit Node(bool leaf);
+    };
+
+    struct Leaf : Node
+    {
+        Value values_[Order];
+        Leaf* next_;
+
+        Leaf();
+    };
+
+    // children_[i] holds keys between keys_[i - 1] and keys_[i], inclusive for duplicates
+    struct Inner : Node
+    {
+        Node* children_[Order + 1];
+
+        Inner();
+    };
+
+    Node* root_;
+    Compare compare_;
+
+    int minKeys(const Node* node) const;
+    int lowerBound(const Node* node, const Key& key) const;
+    int upperBound(const Node* node, const Key& key) const;
+
+    Leaf* findLeaf(const Key& key, int& pos) const;
+
+    // Returns the new right sibling and its separator if node had to split
+    Node* insert(Node* node, Key& key, Value& data, Key& separator);
+
+    bool remove(Node* node, const Key& key);
+    void rebalance(Inner* parent, int index);
+    // Moves the child at index + 1 into the child at index
+    void merge(Inner* parent, int index);
+
+    void print(Node* node, std::string indent);
+
+    void destroyNode(Node* node);
+    void clear(Node* node);
+};
+
+using BPlusTree = BasicBPlusTree<int, std::string>;
+
+#include "bplus_tree.tpp"
+
+// The default tree is compiled once in bplus_tree.cpp
+extern template class BasicBPlusTree<int, std::string>;
\ No newline at end of file
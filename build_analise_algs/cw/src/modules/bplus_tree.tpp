@@ -0,0 +1,526 @@
+#include <iostream>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <iterator>
+
+template <typename Key, typename Value, typename Compare, int Order>
+BasicBPlusTree<Key, Value, Compare, Order>::Node::Node(bool leaf):
+    leaf_(leaf),
+    count_(0)
+{}
+
+template <typename Key, typename Value, typename Compare, int Order>
+BasicBPlusTree<Key, Value, Compare, Order>::Leaf::Leaf():
+    Node(true),
+    next_(nullptr)
+{}
+
+template <typename Key, typename Value, typename Compare, int Order>
+BasicBPlusTree<Key, Value, Compare, Order>::Inner::Inner():
+    Node(false)
+{}
+
+template <typename Key, typename Value, typename Compare, int Order>
+BasicBPlusTree<Key, Value, Compare, Order>::BasicBPlusTree(const Compare& compare):
+    root_(nullptr),
+    compare_(compare)
+{}
+
+template <typename Key, typename Value, typename Compare, int Order>
+BasicBPlusTree<Key, Value, Compare, Order>::~BasicBPlusTree()
+{
+    clear(root_);
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::insert(Key key, Value data)
+{
+    if (root_ == nullptr) {
+        root_ = new Leaf();
+    }
+
+    Key separator;
+    Node* right = insert(root_, key, data, separator);
+
+    if (right != nullptr) {
+        Inner* root = new Inner();
+        root->count_ = 1;
+        root->keys_[0] = std::move(separator);
+        root->children_[0] = root_;
+        root->children_[1] = right;
+        root_ = root;
+    }
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::insert(const std::vector<Entry>& tasks)
+{
+    for (auto& e: tasks) {
+        insert(e.key_, e.data_);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+bool BasicBPlusTree<Key, Value, Compare, Order>::remove(const Key& key)
+{
+    if (root_ == nullptr || !remove(root_, key)) {
+        return false;
+    }
+
+    if (root_->count_ == 0) {
+        Node* root = root_;
+        root_ = root->leaf_ ? nullptr : static_cast<Inner*>(root)->children_[0];
+        destroyNode(root);
+    }
+
+    return true;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+Value* BasicBPlusTree<Key, Value, Compare, Order>::find(const Key& key)
+{
+    int pos;
+    Leaf* leaf = findLeaf(key, pos);
+
+    return leaf == nullptr ? nullptr : &leaf->values_[pos];
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+const Value* BasicBPlusTree<Key, Value, Compare, Order>::find(const Key& key) const
+{
+    int pos;
+    Leaf* leaf = findLeaf(key, pos);
+
+    return leaf == nullptr ? nullptr : &leaf->values_[pos];
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+bool BasicBPlusTree<Key, Value, Compare, Order>::contains(const Key& key) const
+{
+    int pos;
+    return findLeaf(key, pos) != nullptr;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+bool BasicBPlusTree<Key, Value, Compare, Order>::tryGet(const Key& key, Value& out) const
+{
+    int pos;
+    Leaf* leaf = findLeaf(key, pos);
+    if (leaf == nullptr) {
+        return false;
+    }
+
+    out = leaf->values_[pos];
+
+    return true;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::print()
+{
+    if (root_ == nullptr) {
+        std::cout << "Tree is empty." << std::endl;
+    } else {
+        print(root_, "");
+        std::cout << std::endl;
+    }
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::getData(std::vector<Entry>& res)
+{
+    res.clear();
+
+    if (root_ == nullptr) {
+        return;
+    }
+
+    Node* node = root_;
+    while (!node->leaf_) {
+        node = static_cast<Inner*>(node)->children_[0];
+    }
+
+    for (Leaf* leaf = static_cast<Leaf*>(node); leaf != nullptr; leaf = leaf->next_) {
+        for (int i = 0; i < leaf->count_; i++) {
+            res.push_back({leaf->keys_[i], leaf->values_[i]});
+        }
+    }
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::buildFromSorted(const std::vector<Entry>& tasks)
+{
+    buildFromSorted(tasks.begin(), tasks.end());
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+template <typename It>
+void BasicBPlusTree<Key, Value, Compare, Order>::buildFromSorted(It first, It last)
+{
+    clear();
+
+    size_t size = std::distance(first, last);
+    if (size == 0) {
+        return;
+    }
+
+    // Tasks are spread evenly, so every node but the root keeps at least half of its capacity
+    std::vector<Node*> level;
+    std::vector<Key> lowest;
+
+    size_t leaves = (size + Order - 1) / Order;
+    Leaf* previous = nullptr;
+    for (size_t i = 0; i < leaves; i++) {
+        Leaf* leaf = new Leaf();
+        leaf->count_ = size / leaves + (i < size % leaves ? 1 : 0);
+
+        for (int j = 0; j < leaf->count_; j++, ++first) {
+            leaf->keys_[j] = Key(first->key_);
+            leaf->values_[j] = Value(first->data_);
+        }
+
+        if (previous != nullptr) {
+            previous->next_ = leaf;
+        }
+        previous = leaf;
+
+        level.push_back(leaf);
+        lowest.push_back(leaf->keys_[0]);
+    }
+
+    while (level.size() > 1) {
+        size_t groups = (level.size() + Order) / (Order + 1);
+        std::vector<Node*> upper;
+        std::vector<Key> upperLowest;
+
+        size_t index = 0;
+        for (size_t i = 0; i < groups; i++) {
+            Inner* inner = new Inner();
+            int children = level.size() / groups + (i < level.size() % groups ? 1 : 0);
+
+            for (int j = 0; j < children; j++) {
+                inner->children_[j] = level[index + j];
+                if (j > 0) {
+                    inner->keys_[j - 1] = lowest[index + j];
+                }
+            }
+            inner->count_ = children - 1;
+
+            upper.push_back(inner);
+            upperLowest.push_back(lowest[index]);
+            index += children;
+        }
+
+        level.swap(upper);
+        lowest.swap(upperLowest);
+    }
+
+    root_ = level[0];
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::clear()
+{
+    clear(root_);
+    root_ = nullptr;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+int BasicBPlusTree<Key, Value, Compare, Order>::minKeys(const Node* node) const
+{
+    // Splitting a full inner node moves one key up, so its halves get one key less
+    return node->leaf_ ? Order / 2 : (Order - 1) / 2;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+int BasicBPlusTree<Key, Value, Compare, Order>::lowerBound(const Node* node, const Key& key) const
+{
+    return std::lower_bound(node->keys_, node->keys_ + node->count_, key, compare_) - node->keys_;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+int BasicBPlusTree<Key, Value, Compare, Order>::upperBound(const Node* node, const Key& key) const
+{
+    return std::upper_bound(node->keys_, node->keys_ + node->count_, key, compare_) - node->keys_;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+typename BasicBPlusTree<Key, Value, Compare, Order>::Leaf* BasicBPlusTree<Key, Value, Compare, Order>::findLeaf(const Key& key, int& pos) const
+{
+    if (root_ == nullptr) {
+        return nullptr;
+    }
+
+    Node* node = root_;
+    while (!node->leaf_) {
+        node = static_cast<Inner*>(node)->children_[lowerBound(node, key)];
+    }
+
+    // The first task not less than key is either in this leaf or starts the next one
+    Leaf* leaf = static_cast<Leaf*>(node);
+    pos = lowerBound(leaf, key);
+    if (pos == leaf->count_) {
+        leaf = leaf->next_;
+        pos = 0;
+    }
+
+    if (leaf == nullptr || compare_(key, leaf->keys_[pos])) {
+        return nullptr;
+    }
+
+    return leaf;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+typename BasicBPlusTree<Key, Value, Compare, Order>::Node* BasicBPlusTree<Key, Value, Compare, Order>::insert(Node* node, Key& key, Value& data, Key& separator)
+{
+    int pos = upperBound(node, key);
+    int half = Order / 2;
+
+    if (node->leaf_) {
+        Leaf* leaf = static_cast<Leaf*>(node);
+        Leaf* right = nullptr;
+
+        if (leaf->count_ == Order) {
+            right = new Leaf();
+            std::move(leaf->keys_ + half, leaf->keys_ + Order, right->keys_);
+            std::move(leaf->values_ + half, leaf->values_ + Order, right->values_);
+            right->count_ = Order - half;
+            leaf->count_ = half;
+
+            right->next_ = leaf->next_;
+            leaf->next_ = right;
+
+            if (pos > half) {
+                leaf = right;
+                pos -= half;
+            }
+        }
+
+        std::move_backward(leaf->keys_ + pos, leaf->keys_ + leaf->count_, leaf->keys_ + leaf->count_ + 1);
+        std::move_backward(leaf->values_ + pos, leaf->values_ + leaf->count_, leaf->values_ + leaf->count_ + 1);
+        leaf->keys_[pos] = std::move(key);
+        leaf->values_[pos] = std::move(data);
+        leaf->count_++;
+
+        if (right != nullptr) {
+            separator = right->keys_[0];
+        }
+
+        return right;
+    }
+
+    Inner* inner = static_cast<Inner*>(node);
+
+    Key childSeparator;
+    Node* child = insert(inner->children_[pos], key, data, childSeparator);
+    if (child == nullptr) {
+        return nullptr;
+    }
+
+    Inner* right = nullptr;
+
+    if (inner->count_ == Order) {
+        right = new Inner();
+        separator = std::move(inner->keys_[half]);
+        std::move(inner->keys_ + half + 1, inner->keys_ + Order, right->keys_);
+        std::copy(inner->children_ + half + 1, inner->children_ + Order + 1, right->children_);
+        right->count_ = Order - half - 1;
+        inner->count_ = half;
+
+        if (pos > half) {
+            inner = right;
+            pos -= half + 1;
+        }
+    }
+
+    std::move_backward(inner->keys_ + pos, inner->keys_ + inner->count_, inner->keys_ + inner->count_ + 1);
+    std::copy_backward(inner->children_ + pos + 1, inner->children_ + inner->count_ + 1, inner->children_ + inner->count_ + 2);
+    inner->keys_[pos] = std::move(childSeparator);
+    inner->children_[pos + 1] = child;
+    inner->count_++;
+
+    return right;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+bool BasicBPlusTree<Key, Value, Compare, Order>::remove(Node* node, const Key& key)
+{
+    int pos = lowerBound(node, key);
+
+    if (node->leaf_) {
+        Leaf* leaf = static_cast<Leaf*>(node);
+        if (pos == leaf->count_ || compare_(key, leaf->keys_[pos])) {
+            return false;
+        }
+
+        std::move(leaf->keys_ + pos + 1, leaf->keys_ + leaf->count_, leaf->keys_ + pos);
+        std::move(leaf->values_ + pos + 1, leaf->values_ + leaf->count_, leaf->values_ + pos);
+        leaf->count_--;
+        leaf->keys_[leaf->count_] = Key();
+        leaf->values_[leaf->count_] = Value();
+
+        return true;
+    }
+
+    Inner* inner = static_cast<Inner*>(node);
+
+    // Equal keys may go on in the next child while the separator equals key
+    while (!remove(inner->children_[pos], key)) {
+        if (pos == inner->count_ || compare_(key, inner->keys_[pos])) {
+            return false;
+        }
+        pos++;
+    }
+
+    if (inner->children_[pos]->count_ < minKeys(inner->children_[pos])) {
+        rebalance(inner, pos);
+    }
+
+    return true;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::rebalance(Inner* parent, int index)
+{
+    Node* node = parent->children_[index];
+    Node* left = index > 0 ? parent->children_[index - 1] : nullptr;
+    Node* right = index < parent->count_ ? parent->children_[index + 1] : nullptr;
+
+    if (left != nullptr && left->count_ > minKeys(left)) {
+        std::move_backward(node->keys_, node->keys_ + node->count_, node->keys_ + node->count_ + 1);
+
+        if (node->leaf_) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            Leaf* leftLeaf = static_cast<Leaf*>(left);
+            std::move_backward(leaf->values_, leaf->values_ + leaf->count_, leaf->values_ + leaf->count_ + 1);
+
+            leaf->keys_[0] = std::move(leftLeaf->keys_[left->count_ - 1]);
+            leaf->values_[0] = std::move(leftLeaf->values_[left->count_ - 1]);
+            parent->keys_[index - 1] = leaf->keys_[0];
+        } else {
+            Inner* inner = static_cast<Inner*>(node);
+            Inner* leftInner = static_cast<Inner*>(left);
+            std::copy_backward(inner->children_, inner->children_ + inner->count_ + 1, inner->children_ + inner->count_ + 2);
+
+            inner->keys_[0] = std::move(parent->keys_[index - 1]);
+            inner->children_[0] = leftInner->children_[left->count_];
+            parent->keys_[index - 1] = std::move(leftInner->keys_[left->count_ - 1]);
+        }
+
+        node->count_++;
+        left->count_--;
+    } else if (right != nullptr && right->count_ > minKeys(right)) {
+        if (node->leaf_) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            Leaf* rightLeaf = static_cast<Leaf*>(right);
+
+            leaf->keys_[leaf->count_] = std::move(rightLeaf->keys_[0]);
+            leaf->values_[leaf->count_] = std::move(rightLeaf->values_[0]);
+            std::move(rightLeaf->values_ + 1, rightLeaf->values_ + right->count_, rightLeaf->values_);
+            std::move(right->keys_ + 1, right->keys_ + right->count_, right->keys_);
+            parent->keys_[index] = right->keys_[0];
+        } else {
+            Inner* inner = static_cast<Inner*>(node);
+            Inner* rightInner = static_cast<Inner*>(right);
+
+            inner->keys_[inner->count_] = std::move(parent->keys_[index]);
+            inner->children_[inner->count_ + 1] = rightInner->children_[0];
+            parent->keys_[index] = std::move(right->keys_[0]);
+            std::move(right->keys_ + 1, right->keys_ + right->count_, right->keys_);
+            std::copy(rightInner->children_ + 1, rightInner->children_ + right->count_ + 1, rightInner->children_);
+        }
+
+        node->count_++;
+        right->count_--;
+    } else if (left != nullptr) {
+        merge(parent, index - 1);
+    } else {
+        merge(parent, index);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::merge(Inner* parent, int index)
+{
+    Node* left = parent->children_[index];
+    Node* right = parent->children_[index + 1];
+
+    if (left->leaf_) {
+        Leaf* leftLeaf = static_cast<Leaf*>(left);
+        Leaf* rightLeaf = static_cast<Leaf*>(right);
+
+        std::move(right->keys_, right->keys_ + right->count_, left->keys_ + left->count_);
+        std::move(rightLeaf->values_, rightLeaf->values_ + right->count_, leftLeaf->values_ + left->count_);
+        left->count_ += right->count_;
+        leftLeaf->next_ = rightLeaf->next_;
+    } else {
+        Inner* leftInner = static_cast<Inner*>(left);
+        Inner* rightInner = static_cast<Inner*>(right);
+
+        left->keys_[left->count_] = std::move(parent->keys_[index]);
+        std::move(right->keys_, right->keys_ + right->count_, left->keys_ + left->count_ + 1);
+        std::copy(rightInner->children_, rightInner->children_ + right->count_ + 1, leftInner->children_ + left->count_ + 1);
+        left->count_ += right->count_ + 1;
+    }
+
+    std::move(parent->keys_ + index + 1, parent->keys_ + parent->count_, parent->keys_ + index);
+    std::copy(parent->children_ + index + 2, parent->children_ + parent->count_ + 1, parent->children_ + index + 1);
+    parent->count_--;
+
+    destroyNode(right);
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::print(Node* node, std::string indent)
+{
+    std::cout << indent;
+
+    if (node->leaf_) {
+        Leaf* leaf = static_cast<Leaf*>(node);
+        for (int i = 0; i < leaf->count_; i++) {
+            std::cout << (i == 0 ? "" : ", ") << leaf->keys_[i] << ": " << leaf->values_[i];
+        }
+        std::cout << std::endl;
+        return;
+    }
+
+    Inner* inner = static_cast<Inner*>(node);
+    std::cout << "|";
+    for (int i = 0; i < inner->count_; i++) {
+        std::cout << inner->keys_[i] << "|";
+    }
+    std::cout << std::endl;
+
+    for (int i = 0; i <= inner->count_; i++) {
+        print(inner->children_[i], indent + "    ");
+    }
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::destroyNode(Node* node)
+{
+    if (node->leaf_) {
+        delete static_cast<Leaf*>(node);
+    } else {
+        delete static_cast<Inner*>(node);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::clear(Node* node)
+{
+    if (node == nullptr) {
+        return;
+    }
+
+    if (!node->leaf_) {
+        Inner* inner = static_cast<Inner*>(node);
+        for (int i = 0; i <= inner->count_; i++) {
+            clear(inner->children_[i]);
+        }
+    }
+
+    destroyNode(node);
+}
\ No newline at end of file
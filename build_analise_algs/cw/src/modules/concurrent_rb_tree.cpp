@@ -0,0 +1,67 @@
+#include "concurrent_rb_tree.h"
+
+#include <mutex>
+#include <utility>
+
+void ConcurrentRBTree::insert(int key, std::string data)
+{
+    // Allocating the node does not need the lock either, only linking it does
+    RBTree::NodeHandle node = tree_.makeNode(key, std::move(data));
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    tree_.insert(std::move(node));
+}
+
+bool ConcurrentRBTree::remove(int key)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return tree_.remove(key);
+}
+
+void ConcurrentRBTree::insert(const std::vector<Task>& tasks)
+{
+    // Sorting and building the batch does not need the lock, only merging it does
+    RBTree batch;
+    batch.insert(tasks);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    tree_.unite(batch);
+}
+
+void ConcurrentRBTree::remove(const std::vector<int>& keys)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    tree_.remove(keys);
+}
+
+std::string ConcurrentRBTree::find(int key)
+{
+    // Readers share the lock, so they may only call const members of the tree
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const std::string* data = std::as_const(tree_).find(key);
+    return data == nullptr ? "" : *data;
+}
+
+bool ConcurrentRBTree::contains(int key)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return tree_.contains(key);
+}
+
+bool ConcurrentRBTree::tryGet(int key, std::string& out)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return tree_.tryGet(key, out);
+}
+
+void ConcurrentRBTree::getData(std::vector<Task>& res)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    tree_.getData(res);
+}
+
+void ConcurrentRBTree::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    tree_.clear();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "rb_tree.h"
+
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+// RBTree behind a reader-writer lock: lookups share the lock, updates take it alone
+class ConcurrentRBTree
+{
+public:
+    void insert(int key, std::string data);
+    bool remove(int key);
+
+    void insert(const std::vector<Task>& tasks);
+    void remove(const std::vector<int>& keys);
+
+    // Returns a copy, or an empty string if the key is missing
+    std::string find(int key);
+    bool contains(int key);
+    // Copies the data into out, reusing its storage, false if the key is missing
+    bool tryGet(int key, std::string& out);
+
+    void getData(std::vector<Task>& res);
+
+    void clear();
+
+private:
+    RBTree tree_;
+    std::shared_mutex mutex_;
+};
@@ -0,0 +1,424 @@
+#include "persistent_rb_tree.h"
+
+#include <algorithm>
+#include <utility>
+
+PersistentRBTree::NodePtr::NodePtr(std::nullptr_t):
+    node_(nullptr)
+{}
+
+PersistentRBTree::NodePtr::NodePtr(const NodePtr& other):
+    node_(other.node_)
+{
+    if (node_ != nullptr) {
+        node_->refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+PersistentRBTree::NodePtr::NodePtr(NodePtr&& other) noexcept:
+    node_(other.node_)
+{
+    other.node_ = nullptr;
+}
+
+PersistentRBTree::NodePtr& PersistentRBTree::NodePtr::operator=(NodePtr other) noexcept
+{
+    std::swap(node_, other.node_);
+    return *this;
+}
+
+PersistentRBTree::NodePtr::~NodePtr()
+{
+    // The last owner frees the node, which drops its children in turn
+    if (node_ != nullptr && node_->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete node_;
+    }
+}
+
+PersistentRBTree::NodePtr PersistentRBTree::NodePtr::adopt(Node* node)
+{
+    NodePtr res;
+    res.node_ = node;
+    return res;
+}
+
+PersistentRBTree::NodePtr PersistentRBTree::NodePtr::share(Node* node)
+{
+    if (node != nullptr) {
+        node->refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return adopt(node);
+}
+
+PersistentRBTree::Node* PersistentRBTree::NodePtr::release()
+{
+    Node* node = node_;
+    node_ = nullptr;
+    return node;
+}
+
+PersistentRBTree::Node::Node(int key, unsigned long long order, std::shared_ptr<const std::string> data, Color color):
+    key_(key),
+    order_(order),
+    data_(std::move(data)),
+    color_(color),
+    refs_(1)
+{}
+
+PersistentRBTree::Node::Node(const Node& other):
+    key_(other.key_),
+    order_(other.order_),
+    data_(other.data_),
+    color_(other.color_),
+    left_(other.left_),
+    right_(other.right_),
+    refs_(1)
+{}
+
+PersistentRBTree::RootGuard::RootGuard(const PersistentRBTree& tree):
+    slot_(tree.claimSlot()),
+    root_(tree.root_.load())
+{
+    // Once the root is still current after being announced, no writer can free it
+    while (true) {
+        slot_.node_.store(root_);
+        Node* current = tree.root_.load();
+        if (current == root_) {
+            break;
+        }
+        root_ = current;
+    }
+}
+
+PersistentRBTree::RootGuard::~RootGuard()
+{
+    slot_.node_.store(nullptr, std::memory_order_release);
+    slot_.busy_.store(false, std::memory_order_release);
+}
+
+PersistentRBTree::Snapshot::Snapshot(NodePtr root):
+    root_(std::move(root))
+{}
+
+const std::string* PersistentRBTree::Snapshot::find(int key) const
+{
+    const Node* node = findNode(root_.get(), key);
+    return node == nullptr ? nullptr : node->data_.get();
+}
+
+void PersistentRBTree::Snapshot::getData(std::vector<Task>& res) const
+{
+    res.clear();
+
+    std::vector<const Node*> stack;
+    const Node* node = root_.get();
+    while (node != nullptr || !stack.empty()) {
+        while (node != nullptr) {
+            stack.push_back(node);
+            node = node->left_.get();
+        }
+
+        node = stack.back();
+        stack.pop_back();
+        res.push_back({node->key_, *node->data_});
+        node = node->right_.get();
+    }
+}
+
+PersistentRBTree::PersistentRBTree():
+    root_(nullptr),
+    nextOrder_(0)
+{}
+
+PersistentRBTree::~PersistentRBTree()
+{
+    // No reader can be left, so every owned version is dropped
+    NodePtr::adopt(root_.load());
+    for (Node* old : retired_) {
+        NodePtr::adopt(old);
+    }
+}
+
+void PersistentRBTree::insert(int key, std::string data)
+{
+    auto payload = std::make_shared<const std::string>(std::move(data));
+
+    std::lock_guard<std::mutex> lock(writeMutex_);
+
+    NodePtr root = insert(NodePtr::share(root_.load()), key, nextOrder_++, payload);
+    root->color_ = BLACK;
+
+    publish(std::move(root));
+}
+
+bool PersistentRBTree::remove(int key)
+{
+    std::lock_guard<std::mutex> lock(writeMutex_);
+
+    NodePtr root = NodePtr::share(root_.load());
+    const Node* node = findNode(root.get(), key);
+    if (node == nullptr) {
+        return false;
+    }
+    unsigned long long order = node->order_;
+
+    root = copy(root);
+    if (!isRed(root->left_) && !isRed(root->right_)) {
+        root->color_ = RED;
+    }
+
+    root = remove(root, key, order);
+    if (root != nullptr) {
+        root->color_ = BLACK;
+    }
+
+    publish(std::move(root));
+
+    return true;
+}
+
+std::shared_ptr<const std::string> PersistentRBTree::find(int key) const
+{
+    RootGuard guard(*this);
+    const Node* node = findNode(guard.get(), key);
+    return node == nullptr ? nullptr : node->data_;
+}
+
+void PersistentRBTree::getData(std::vector<Task>& res) const
+{
+    snapshot().getData(res);
+}
+
+void PersistentRBTree::clear()
+{
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    publish(nullptr);
+}
+
+PersistentRBTree::Snapshot PersistentRBTree::snapshot() const
+{
+    RootGuard guard(*this);
+    return Snapshot(NodePtr::share(guard.get()));
+}
+
+PersistentRBTree::HazardSlot& PersistentRBTree::claimSlot() const
+{
+    // Each thread starts at its own slot, so readers only probe further when
+    // more threads than slots read at once
+    static std::atomic<size_t> threads(0);
+    thread_local size_t first = threads.fetch_add(1, std::memory_order_relaxed);
+
+    for (size_t i = first;; i++) {
+        HazardSlot& slot = hazards_[i % hazardSlots];
+        if (!slot.busy_.load(std::memory_order_relaxed) && !slot.busy_.exchange(true, std::memory_order_acquire)) {
+            return slot;
+        }
+    }
+}
+
+void PersistentRBTree::publish(NodePtr root)
+{
+    Node* old = root_.exchange(root.release());
+    if (old != nullptr) {
+        retired_.push_back(old);
+    }
+
+    std::vector<Node*> held;
+    for (auto& slot : hazards_) {
+        Node* node = slot.node_.load();
+        if (node != nullptr) {
+            held.push_back(node);
+        }
+    }
+
+    auto kept = std::partition(retired_.begin(), retired_.end(), [&held](Node* node) {
+        return std::find(held.begin(), held.end(), node) != held.end();
+    });
+    for (auto it = kept; it != retired_.end(); ++it) {
+        NodePtr::adopt(*it);
+    }
+    retired_.erase(kept, retired_.end());
+}
+
+const PersistentRBTree::Node* PersistentRBTree::findNode(const Node* root, int key)
+{
+    // Equal keys are ordered by insertion, so the leftmost match is the oldest task
+    const Node* node = root;
+    const Node* res = nullptr;
+
+    while (node != nullptr) {
+        if (node->key_ < key) {
+            node = node->right_.get();
+        } else {
+            if (node->key_ == key) {
+                res = node;
+            }
+            node = node->left_.get();
+        }
+    }
+
+    return res;
+}
+
+bool PersistentRBTree::less(int key, unsigned long long order, const NodePtr& node)
+{
+    return key < node->key_ || (key == node->key_ && order < node->order_);
+}
+
+PersistentRBTree::NodePtr PersistentRBTree::copy(const NodePtr& node)
+{
+    return NodePtr::adopt(new Node(*node.get()));
+}
+
+bool PersistentRBTree::isRed(const NodePtr& node)
+{
+    return node != nullptr && node->color_ == RED;
+}
+
+// The helpers below expect node to be a private copy and copy any child they change
+
+PersistentRBTree::NodePtr PersistentRBTree::rotateL(NodePtr node)
+{
+    NodePtr child = copy(node->right_);
+    node->right_ = child->left_;
+    child->left_ = node;
+    child->color_ = node->color_;
+    node->color_ = RED;
+
+    return child;
+}
+
+PersistentRBTree::NodePtr PersistentRBTree::rotateR(NodePtr node)
+{
+    NodePtr child = copy(node->left_);
+    node->left_ = child->right_;
+    child->right_ = node;
+    child->color_ = node->color_;
+    node->color_ = RED;
+
+    return child;
+}
+
+void PersistentRBTree::flipColors(const NodePtr& node)
+{
+    node->color_ = node->color_ == RED ? BLACK : RED;
+
+    node->left_ = copy(node->left_);
+    node->left_->color_ = node->left_->color_ == RED ? BLACK : RED;
+
+    node->right_ = copy(node->right_);
+    node->right_->color_ = node->right_->color_ == RED ? BLACK : RED;
+}
+
+PersistentRBTree::NodePtr PersistentRBTree::fixUp(NodePtr node)
+{
+    if (isRed(node->right_) && !isRed(node->left_)) {
+        node = rotateL(node);
+    }
+    if (isRed(node->left_) && isRed(node->left_->left_)) {
+        node = rotateR(node);
+    }
+    if (isRed(node->left_) && isRed(node->right_)) {
+        flipColors(node);
+    }
+
+    return node;
+}
+
+PersistentRBTree::NodePtr PersistentRBTree::moveRedLeft(NodePtr node)
+{
+    flipColors(node);
+
+    if (isRed(node->right_->left_)) {
+        node->right_ = rotateR(node->right_);
+        node = rotateL(node);
+        flipColors(node);
+    }
+
+    return node;
+}
+
+PersistentRBTree::NodePtr PersistentRBTree::moveRedRight(NodePtr node)
+{
+    flipColors(node);
+
+    if (isRed(node->left_->left_)) {
+        node = rotateR(node);
+        flipColors(node);
+    }
+
+    return node;
+}
+
+PersistentRBTree::NodePtr PersistentRBTree::insert(const NodePtr& node, int key, unsigned long long order, const std::shared_ptr<const std::string>& data)
+{
+    if (node == nullptr) {
+        return NodePtr::adopt(new Node(key, order, data, RED));
+    }
+
+    NodePtr res = copy(node);
+    if (less(key, order, res)) {
+        res->left_ = insert(res->left_, key, order, data);
+    } else {
+        res->right_ = insert(res->right_, key, order, data);
+    }
+
+    return fixUp(res);
+}
+
+PersistentRBTree::NodePtr PersistentRBTree::removeMin(const NodePtr& node)
+{
+    if (node->left_ == nullptr) {
+        return nullptr;
+    }
+
+    NodePtr res = copy(node);
+    if (!isRed(res->left_) && !isRed(res->left_->left_)) {
+        res = moveRedLeft(res);
+    }
+
+    res->left_ = removeMin(res->left_);
+
+    return fixUp(res);
+}
+
+PersistentRBTree::NodePtr PersistentRBTree::remove(const NodePtr& node, int key, unsigned long long order)
+{
+    NodePtr res = copy(node);
+
+    if (less(key, order, res)) {
+        if (!isRed(res->left_) && !isRed(res->left_->left_)) {
+            res = moveRedLeft(res);
+        }
+
+        res->left_ = remove(res->left_, key, order);
+    } else {
+        if (isRed(res->left_)) {
+            res = rotateR(res);
+        }
+
+        if (key == res->key_ && order == res->order_ && res->right_ == nullptr) {
+            return nullptr;
+        }
+
+        if (!isRed(res->right_) && !isRed(res->right_->left_)) {
+            res = moveRedRight(res);
+        }
+
+        if (key == res->key_ && order == res->order_) {
+            const Node* min = res->right_.get();
+            while (min->left_ != nullptr) {
+                min = min->left_.get();
+            }
+
+            res->key_ = min->key_;
+            res->order_ = min->order_;
+            res->data_ = min->data_;
+            res->right_ = removeMin(res->right_);
+        } else {
+            res->right_ = remove(res->right_, key, order);
+        }
+    }
+
+    return fixUp(res);
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "rb_tree.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Copy-on-write left-leaning red-black tree. Updates copy the O(log n) nodes on
+// their path and publish a new root, so readers never wait for writers and a snapshot
+// stays valid while writes continue. Nodes count their own references and the root is
+// a plain atomic pointer: a reader announces it in a hazard slot, and a writer frees
+// a replaced root only once no slot holds it, so reads take no lock at all
+class PersistentRBTree
+{
+private:
+    struct Node;
+
+    // Owns one reference to a node, the count lives in the node itself
+    class NodePtr
+    {
+    public:
+        NodePtr(std::nullptr_t = nullptr);
+        NodePtr(const NodePtr& other);
+        NodePtr(NodePtr&& other) noexcept;
+        NodePtr& operator=(NodePtr other) noexcept;
+        ~NodePtr();
+
+        // Takes over a reference the caller already owns, or adds a new one
+        static NodePtr adopt(Node* node);
+        static NodePtr share(Node* node);
+        // Gives up the reference without dropping it
+        Node* release();
+
+        Node* get() const { return node_; }
+        Node* operator->() const { return node_; }
+        bool operator==(std::nullptr_t) const { return node_ == nullptr; }
+        bool operator!=(std::nullptr_t) const { return node_ != nullptr; }
+
+    private:
+        Node* node_;
+    };
+
+public:
+    class Snapshot
+    {
+    public:
+        // Returns nullptr if the key is missing, the data lives as long as the snapshot
+        const std::string* find(int key) const;
+
+        void getData(std::vector<Task>& res) const;
+
+    private:
+        friend class PersistentRBTree;
+
+        explicit Snapshot(NodePtr root);
+
+        NodePtr root_;
+    };
+
+    PersistentRBTree();
+    ~PersistentRBTree();
+
+    PersistentRBTree(const PersistentRBTree&) = delete;
+    PersistentRBTree& operator=(const PersistentRBTree&) = delete;
+
+    void insert(int key, std::string data);
+    // Removes the oldest task with the key, false if the key is missing
+    bool remove(int key);
+
+    // The data of the oldest task with the key, nullptr if the key is missing
+    std::shared_ptr<const std::string> find(int key) const;
+
+    void getData(std::vector<Task>& res) const;
+
+    void clear();
+
+    Snapshot snapshot() const;
+
+private:
+    // Published nodes are never modified, updates work on fresh copies
+    struct Node
+    {
+        int key_;
+        // Insertion number breaking ties between equal keys, so the order is strict
+        unsigned long long order_;
+        std::shared_ptr<const std::string> data_;
+        Color color_;
+
+        NodePtr left_;
+        NodePtr right_;
+
+        // Versions and snapshots sharing the node
+        std::atomic<long> refs_;
+
+        Node(int key, unsigned long long order, std::shared_ptr<const std::string> data, Color color);
+        // Copies everything but the count, which starts at one for the caller
+        Node(const Node& other);
+    };
+
+    // A reader claims a free slot and publishes the root it is about to use there
+    struct alignas(64) HazardSlot
+    {
+        std::atomic<bool> busy_ {false};
+        std::atomic<Node*> node_ {nullptr};
+    };
+
+    static const size_t hazardSlots = 64;
+
+    // Keeps the current root alive for a reader without touching its count
+    class RootGuard
+    {
+    public:
+        explicit RootGuard(const PersistentRBTree& tree);
+        ~RootGuard();
+
+        RootGuard(const RootGuard&) = delete;
+        RootGuard& operator=(const RootGuard&) = delete;
+
+        Node* get() const { return root_; }
+
+    private:
+        HazardSlot& slot_;
+        Node* root_;
+    };
+
+    // Owns one reference to the current version
+    std::atomic<Node*> root_;
+    mutable std::array<HazardSlot, hazardSlots> hazards_;
+
+    // Guards updates and the replaced roots some reader may still hold
+    std::mutex writeMutex_;
+    std::vector<Node*> retired_;
+    unsigned long long nextOrder_;
+
+    HazardSlot& claimSlot() const;
+    // Swaps in a new root and frees the replaced ones no reader holds, expects writeMutex_ held
+    void publish(NodePtr root);
+
+    static const Node* findNode(const Node* root, int key);
+    static bool less(int key, unsigned long long order, const NodePtr& node);
+
+    static NodePtr copy(const NodePtr& node);
+    static bool isRed(const NodePtr& node);
+
+    static NodePtr rotateL(NodePtr node);
+    static NodePtr rotateR(NodePtr node);
+    static void flipColors(const NodePtr& node);
+    static NodePtr fixUp(NodePtr node);
+
+    static NodePtr moveRedLeft(NodePtr node);
+    static NodePtr moveRedRight(NodePtr node);
+
+    static NodePtr insert(const NodePtr& node, int key, unsigned long long order, const std::shared_ptr<const std::string>& data);
+    static NodePtr removeMin(const NodePtr& node);
+    static NodePtr remove(const NodePtr& node, int key, unsigned long long order);
+};
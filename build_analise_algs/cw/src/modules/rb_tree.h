@@ -1,66 +1,292 @@
+#pragma once
+
 #include <iostream>
 #include <string>
 #include <vector>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <chrono>
+#include <set>
 
-struct Task
+template <typename Key, typename Value>
+struct BasicTask
 {
-    int key_;
-    std::string data_;
+    Key key_;
+    Value data_;
 };
 
+using Task = BasicTask<int, std::string>;
+
 enum Color
 {
     RED,
     BLACK
 };
 
-class RBTree
+/*
+Handling of equal keys
+- MULTI -- every task is kept, equal keys stay in insertion order, so the tasks of a key
+  form one contiguous range; find and remove take the oldest of them
+- UNIQUE -- one task per key, inserting an existing key replaces its data
+*/
+enum DuplicatePolicy
+{
+    MULTI,
+    UNIQUE
+};
+
+template <typename Key, typename Value, typename Compare = std::less<Key>, typename Allocator = std::allocator<BasicTask<Key, Value>>>
+class BasicRBTree
 {
+private:
+    struct Node;
+
 public:
-    RBTree();
-    ~RBTree();
+    using Entry = BasicTask<Key, Value>;
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    explicit BasicRBTree(const Compare& compare = Compare(), const Allocator& allocator = Allocator());
+    explicit BasicRBTree(DuplicatePolicy policy, const Compare& compare = Compare(), const Allocator& allocator = Allocator());
+    ~BasicRBTree();
+
+    BasicRBTree(const BasicRBTree&) = delete;
+    BasicRBTree& operator=(const BasicRBTree&) = delete;
+
+    void insert(Key key, Value data);
+    // Constructs the value in place from args
+    template <typename K, typename... Args>
+    void emplace(K&& key, Args&&... args);
+
+    // A task allocated ahead of its insert, e.g. before taking a lock, which then needs a
+    // thread-safe allocator. A handle that is never inserted frees its task
+    class NodeHandle
+    {
+    public:
+        NodeHandle(NodeHandle&& other) noexcept;
+        NodeHandle& operator=(const NodeHandle&) = delete;
+        ~NodeHandle();
+
+    private:
+        friend class BasicRBTree;
+
+        NodeHandle(BasicRBTree* tree, Node* node);
+
+        BasicRBTree* tree_;
+        Node* node_;
+    };
+
+    NodeHandle makeNode(Key key, Value data);
+    // Takes a handle made by makeNode of this tree
+    void insert(NodeHandle node);
+
+    // Inserts a task that expires at deadline. Inserts evict expired tasks first, lookups never
+    // modify the tree and still see them until the next insert or evictExpired. Under UNIQUE
+    // an insert replaces the deadline too
+    void insert(Key key, Value data, TimePoint deadline);
+    // Removes every task whose deadline is not after now in O(k log n), returns their number
+    size_t evictExpired(TimePoint now = Clock::now());
+
+    // False if the key is missing
+    bool remove(const Key& key);
+    // Removes every task with the key in O(log n + k), returns their number
+    size_t eraseAll(const Key& key);
+
+    // Priority queue access in O(1), nullptr if the tree is empty
+    Value* min();
+    Value* max();
+    const Key* minKey() const;
+    const Key* maxKey() const;
+
+    // Moves the first or last task out of the tree in O(log n), false if the tree is empty
+    bool popMin(Entry& res);
+    bool popMax(Entry& res);
+
+    // Moves the oldest task of key to newKey, reusing its node and data; false if key is missing.
+    // Under UNIQUE it replaces the task already at newKey
+    bool changePriority(const Key& key, const Key& newKey);
+
+    // O(log n + k) for the k tasks with the key
+    size_t count(const Key& key) const;
+    void getEqual(const Key& key, std::vector<Entry>& res) const;
+
+    // Batch updates, O(m log(n/m + 1)) for a batch of m keys
+    void insert(const std::vector<Entry>& tasks);
+    void remove(const std::vector<Key>& keys);
 
-    void insert(int key, std::string data);
-    void remove(int key);
+    // Moves every task of other into this tree. Under UNIQUE its data wins for equal keys
+    // and only the newest task of each key in other is kept
+    void unite(BasicRBTree& other);
+    // Removes every task whose key occurs in other
+    void subtract(const BasicRBTree& other);
 
-    std::string find(int key);
+    // Appends other, whose keys must not be less than any key here; UNIQUE as in unite.
+    // Split and join take O(log n), plus O(m log n) for the m moved tasks when the hash index
+    // is on or tasks have deadlines
+    void join(BasicRBTree& other);
+    // Moves tasks with keys not less than key into other
+    void split(const Key& key, BasicRBTree& other);
+
+    // Returns nullptr if the key is missing. Pointers from find, min and max stay valid
+    // until the next update, which includes an insert evicting expired tasks
+    Value* find(const Key& key);
+    const Value* find(const Key& key) const;
+
+    // Lookup by any type the comparator accepts, e.g. with std::less<>
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    Value* find(const K& key);
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    const Value* find(const K& key) const;
+
+    bool contains(const Key& key) const;
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    bool contains(const K& key) const;
+
+    // Copies the data into out, reusing its storage, false if the key is missing
+    bool tryGet(const Key& key, Value& out) const;
 
     void print();
 
-    void getData(std::vector<Task>& res);
+    void getData(std::vector<Entry>& res) const;
+
+    // Replaces the contents with tasks, which must be sorted by key, in O(n).
+    // Under UNIQUE the last task of each key wins
+    void buildFromSorted(const std::vector<Entry>& tasks);
+    // Same for any random access range of elements with key_ and data_ members
+    // that Key and Value can be constructed from
+    template <typename It>
+    void buildFromSorted(It first, It last);
 
     void clear();
 
+    // Checks the red-black and search tree invariants, parent links and cached bounds in O(n)
+    bool verify() const;
+
+    // Optional hash index from each key to its oldest node, so find, contains, tryGet, remove,
+    // count and getEqual skip the descent. Updates keep it in sync; split and join touch only
+    // the moved tasks, buildFromSorted rebuilds it in O(n). std::hash<Key> must agree with
+    // Compare on equal keys
+    void setHashIndex(bool enabled);
+    bool hasHashIndex() const;
+
 private:
     struct Node
     {
-        std::string data_;
+        Value data_;
 
-        int key_;
+        Key key_;
         Color color_;
+        // TimePoint::max() for tasks that never expire
+        TimePoint deadline_;
 
         Node* parent_;
         Node* left_;
         Node* right_;
 
-        Node(int key, std::string data);
+        template <typename K, typename... Args>
+        Node(K&& key, Args&&... args);
     };
 
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAllocator>;
+
     Node* root_;
+    Compare compare_;
+    NodeAllocator alloc_;
+    DuplicatePolicy policy_;
+
+    // First and last node in key order, kept up to date by every update
+    Node* leftmost_;
+    Node* rightmost_;
+
+    // Hash index: open addressing with linear probing, nullptr marks a free slot
+    std::vector<Node*> indexSlots_;
+    size_t indexCount_;
+    int indexShift_;
+    bool indexed_;
+
+    // Tasks with a deadline, earliest first
+    std::set<std::pair<TimePoint, Node*>> deadlines_;
+
+    template <typename... Args>
+    Node* createNode(Args&&... args);
+    void destroyNode(Node* node);
 
-    void rotateL(Node* node);
-    void rotateR(Node* node);
+    // The leftmost, that is the oldest, task with the key
+    template <typename K>
+    Node* findNode(const K& key) const;
+    // Same through the hash index when it is on
+    Node* lookup(const Key& key) const;
+    bool equivalent(const Key& first, const Key& second) const;
 
-    void fixInsert(Node* node);
-    void fixRemove(Node* node);
+    // Home slot of the key and the slot holding it, or the free slot ending its probe
+    size_t indexSlot(const Key& key) const;
+    size_t indexProbe(const Key& key) const;
+    Node* indexFind(const Key& key) const;
+    // Adds node unless its key is already indexed
+    void indexPut(Node* node);
+    void indexEraseSlot(size_t slot);
+    // Drops the key or points it at its oldest node after a batch update
+    void indexErase(const Key& key);
+    void indexRefresh(const Key& key);
+    // Keeps the key indexed when its oldest node leaves the tree
+    void indexUnlink(Node* node);
+    void indexResize(size_t capacity);
+    void indexRebuild();
+
+    void retime(Node* node, TimePoint deadline);
+    // Forgets the deadlines of every task with the key before a bulk removal frees them
+    void dropDeadlines(const Key& key);
+    void evictLazily();
+
+    // Removes every task followed by one with an equal key, making the tree fit UNIQUE
+    void keepNewest();
+
+    void rotateL(Node* node, Node*& root);
+    void rotateR(Node* node, Node*& root);
+
+    // Inserts a detached node into the tree or removes one from it without freeing
+    void link(Node* node);
+    void unlink(Node* node);
+    bool pop(Node* node, Entry& res);
+    void updateBounds();
+
+    void fixInsert(Node* node, Node*& root);
+    void fixRemove(Node* node, Node* parent);
 
     Node* minKeyNode(Node* node);
+    Node* next(Node* node) const;
+    Node* prev(Node* node) const;
 
     void transplant(Node* u, Node* v);
 
-    void print(Node* node, std::string indent, int l_or_r);
+    template <typename It>
+    Node* build(It first, It last);
+    template <typename It>
+    Node* build(It first, int left, int right, int depth, int redDepth);
+
+    // Join-based algorithms below work on detached subtrees and return their new roots.
+    // Large batches run them on several threads, so the allocator must be thread-safe
+    int blackHeight(Node* node);
 
-    void getData(Node* node, std::vector<Task>& res);
+    Node* join(Node* left, Node* middle, Node* right);
+    Node* join(Node* left, Node* right);
+    Node* splitLast(Node* node, Node*& last);
+    void split(Node* node, const Key& key, bool inclusive, Node*& left, Node*& right);
+
+    Node* unite(Node* first, Node* second, int depth);
+    Node* subtract(Node* node, const std::vector<Key>& keys, int left, int right, int depth);
+
+    int parallelDepth(size_t batchSize);
+    size_t countNodes(Node* node);
 
     void clear(Node* node);
-};
\ No newline at end of file
+};
+
+using RBTree = BasicRBTree<int, std::string>;
+
+#include "rb_tree.tpp"
+
+// The default tree is compiled once in rb_tree.cpp
+extern template class BasicRBTree<int, std::string>;
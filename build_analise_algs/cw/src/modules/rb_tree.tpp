@@ -0,0 +1,1702 @@
+#include <iostream>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <iterator>
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+template <typename K, typename... Args>
+BasicRBTree<Key, Value, Compare, Allocator>::Node::Node(K&& key, Args&&... args):
+    data_(std::forward<Args>(args)...),
+    key_(std::forward<K>(key)),
+    color_(RED),
+    deadline_(TimePoint::max()),
+    parent_(nullptr),
+    left_(nullptr),
+    right_(nullptr)
+{}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+BasicRBTree<Key, Value, Compare, Allocator>::BasicRBTree(const Compare& compare, const Allocator& allocator):
+    BasicRBTree(MULTI, compare, allocator)
+{}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+BasicRBTree<Key, Value, Compare, Allocator>::BasicRBTree(DuplicatePolicy policy, const Compare& compare, const Allocator& allocator):
+    root_(nullptr),
+    compare_(compare),
+    alloc_(allocator),
+    policy_(policy),
+    leftmost_(nullptr),
+    rightmost_(nullptr),
+    indexCount_(0),
+    indexShift_(64),
+    indexed_(false)
+{}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+BasicRBTree<Key, Value, Compare, Allocator>::~BasicRBTree()
+{
+    clear(root_);
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::insert(Key key, Value data)
+{
+    emplace(std::move(key), std::move(data));
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+template <typename K, typename... Args>
+void BasicRBTree<Key, Value, Compare, Allocator>::emplace(K&& key, Args&&... args)
+{
+    evictLazily();
+    link(createNode(std::forward<K>(key), std::forward<Args>(args)...));
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+BasicRBTree<Key, Value, Compare, Allocator>::NodeHandle::NodeHandle(BasicRBTree* tree, Node* node):
+    tree_(tree),
+    node_(node)
+{}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+BasicRBTree<Key, Value, Compare, Allocator>::NodeHandle::NodeHandle(NodeHandle&& other) noexcept:
+    tree_(other.tree_),
+    node_(other.node_)
+{
+    other.node_ = nullptr;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+BasicRBTree<Key, Value, Compare, Allocator>::NodeHandle::~NodeHandle()
+{
+    if (node_ != nullptr) {
+        tree_->destroyNode(node_);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+typename BasicRBTree<Key, Value, Compare, Allocator>::NodeHandle BasicRBTree<Key, Value, Compare, Allocator>::makeNode(Key key, Value data)
+{
+    return NodeHandle(this, createNode(std::move(key), std::move(data)));
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::insert(NodeHandle node)
+{
+    evictLazily();
+
+    Node* detached = node.node_;
+    node.node_ = nullptr;
+    link(detached);
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::insert(Key key, Value data, TimePoint deadline)
+{
+    evictLazily();
+
+    Node* node = createNode(std::move(key), std::move(data));
+    node->deadline_ = deadline;
+    link(node);
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+size_t BasicRBTree<Key, Value, Compare, Allocator>::evictExpired(TimePoint now)
+{
+    size_t res = 0;
+
+    while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+        Node* node = deadlines_.begin()->second;
+        unlink(node);
+        destroyNode(node);
+        res++;
+    }
+
+    return res;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+bool BasicRBTree<Key, Value, Compare, Allocator>::remove(const Key& key)
+{
+    Node* node = lookup(key);
+
+    if (node == nullptr) {
+        return false;
+    }
+
+    unlink(node);
+    destroyNode(node);
+
+    return true;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+size_t BasicRBTree<Key, Value, Compare, Allocator>::eraseAll(const Key& key)
+{
+    if (lookup(key) == nullptr) {
+        return 0;
+    }
+    // Probing compares with the indexed node, so it goes before the node is freed
+    if (indexed_) {
+        indexErase(key);
+    }
+    dropDeadlines(key);
+
+    Node* less = nullptr;
+    Node* rest = nullptr;
+    Node* equal = nullptr;
+    Node* greater = nullptr;
+    split(root_, key, false, less, rest);
+    split(rest, key, true, equal, greater);
+
+    size_t res = countNodes(equal);
+    clear(equal);
+
+    root_ = join(less, greater);
+    if (root_ != nullptr) {
+        root_->color_ = BLACK;
+    }
+    updateBounds();
+
+    return res;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+size_t BasicRBTree<Key, Value, Compare, Allocator>::count(const Key& key) const
+{
+    size_t res = 0;
+    for (Node* node = lookup(key); node != nullptr && !compare_(key, node->key_); node = next(node)) {
+        res++;
+    }
+
+    return res;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::getEqual(const Key& key, std::vector<Entry>& res) const
+{
+    res.clear();
+    for (Node* node = lookup(key); node != nullptr && !compare_(key, node->key_); node = next(node)) {
+        res.push_back({node->key_, node->data_});
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+Value* BasicRBTree<Key, Value, Compare, Allocator>::min()
+{
+    return leftmost_ == nullptr ? nullptr : &leftmost_->data_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+Value* BasicRBTree<Key, Value, Compare, Allocator>::max()
+{
+    return rightmost_ == nullptr ? nullptr : &rightmost_->data_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+const Key* BasicRBTree<Key, Value, Compare, Allocator>::minKey() const
+{
+    return leftmost_ == nullptr ? nullptr : &leftmost_->key_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+const Key* BasicRBTree<Key, Value, Compare, Allocator>::maxKey() const
+{
+    return rightmost_ == nullptr ? nullptr : &rightmost_->key_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+bool BasicRBTree<Key, Value, Compare, Allocator>::popMin(Entry& res)
+{
+    return pop(leftmost_, res);
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+bool BasicRBTree<Key, Value, Compare, Allocator>::popMax(Entry& res)
+{
+    return pop(rightmost_, res);
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+bool BasicRBTree<Key, Value, Compare, Allocator>::changePriority(const Key& key, const Key& newKey)
+{
+    Node* node = lookup(key);
+    if (node == nullptr) {
+        return false;
+    }
+
+    // Under UNIQUE the moved task replaces the one at newKey, so link keeps its node
+    if (policy_ == UNIQUE) {
+        Node* existing = lookup(newKey);
+        if (existing != nullptr && existing != node) {
+            unlink(existing);
+            destroyNode(existing);
+        }
+    }
+
+    unlink(node);
+    node->key_ = newKey;
+    link(node);
+
+    return true;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+Value* BasicRBTree<Key, Value, Compare, Allocator>::find(const Key& key)
+{
+    Node* node = lookup(key);
+    return node == nullptr ? nullptr : &node->data_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+const Value* BasicRBTree<Key, Value, Compare, Allocator>::find(const Key& key) const
+{
+    Node* node = lookup(key);
+    return node == nullptr ? nullptr : &node->data_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+template <typename K, typename C, typename>
+Value* BasicRBTree<Key, Value, Compare, Allocator>::find(const K& key)
+{
+    Node* node = findNode(key);
+    return node == nullptr ? nullptr : &node->data_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+template <typename K, typename C, typename>
+const Value* BasicRBTree<Key, Value, Compare, Allocator>::find(const K& key) const
+{
+    Node* node = findNode(key);
+    return node == nullptr ? nullptr : &node->data_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+bool BasicRBTree<Key, Value, Compare, Allocator>::contains(const Key& key) const
+{
+    return lookup(key) != nullptr;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+template <typename K, typename C, typename>
+bool BasicRBTree<Key, Value, Compare, Allocator>::contains(const K& key) const
+{
+    return findNode(key) != nullptr;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+bool BasicRBTree<Key, Value, Compare, Allocator>::tryGet(const Key& key, Value& out) const
+{
+    Node* node = lookup(key);
+    if (node == nullptr) {
+        return false;
+    }
+
+    out = node->data_;
+
+    return true;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::print()
+{
+    if (root_ == nullptr) {
+        std::cout << "Tree is empty." << std::endl;
+        return;
+    }
+
+    // Preorder walk over the parent pointers, every level adds one step to the indent
+    std::string indent;
+    Node* node = root_;
+
+    while (node != nullptr) {
+        std::cout << indent;
+
+        if (node == root_) {
+            std::cout << "Root  ";
+            indent += "    ";
+        } else if (node == node->parent_->right_) {
+            std::cout << "R----";
+            indent += "   ";
+        } else {
+            std::cout << "L----";
+            indent += "|  ";
+        }
+
+        std::string sColor = (node->color_ == RED) ? "RED" : "BLACK";
+        std::cout << node->key_ << ": " << node->data_ << "(" << sColor << ")" << std::endl;
+
+        if (node->left_ != nullptr) {
+            node = node->left_;
+        } else if (node->right_ != nullptr) {
+            node = node->right_;
+        } else {
+            // Climb to the nearest left child with a right sibling still to print
+            while (node != nullptr) {
+                indent.resize(indent.size() - (node == root_ ? 4 : 3));
+
+                Node* parent = node->parent_;
+                if (parent != nullptr && node == parent->left_ && parent->right_ != nullptr) {
+                    node = parent->right_;
+                    break;
+                }
+                node = parent;
+            }
+        }
+    }
+
+    std::cout << std::endl;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::getData(std::vector<Entry>& res) const
+{
+    res.clear();
+    for (Node* node = leftmost_; node != nullptr; node = next(node)) {
+        res.push_back({node->key_, node->data_});
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::buildFromSorted(const std::vector<Entry>& tasks)
+{
+    buildFromSorted(tasks.begin(), tasks.end());
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+template <typename It>
+void BasicRBTree<Key, Value, Compare, Allocator>::buildFromSorted(It first, It last)
+{
+    clear();
+    root_ = build(first, last);
+    updateBounds();
+    indexRebuild();
+
+    if (policy_ == UNIQUE) {
+        keepNewest();
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::insert(const std::vector<Entry>& tasks)
+{
+    std::vector<Entry> sorted = tasks;
+    std::stable_sort(sorted.begin(), sorted.end(), [this](const Entry& a, const Entry& b) { return compare_(a.key_, b.key_); });
+
+    if (policy_ == UNIQUE) {
+        // The last task of a key wins, as with one insert after another
+        auto last = std::unique(sorted.rbegin(), sorted.rend(), [this](const Entry& a, const Entry& b) {
+            return !compare_(a.key_, b.key_) && !compare_(b.key_, a.key_);
+        });
+        sorted.erase(sorted.begin(), last.base());
+    }
+
+    // The build moves the keys out of sorted
+    std::vector<Key> keys;
+    if (indexed_) {
+        for (auto& e: sorted) {
+            keys.push_back(e.key_);
+        }
+    }
+
+    // Replaced tasks take the deadline of the new ones, that is none
+    if (policy_ == UNIQUE && !deadlines_.empty()) {
+        for (auto& e: sorted) {
+            Node* existing = findNode(e.key_);
+            if (existing != nullptr) {
+                retime(existing, TimePoint::max());
+            }
+        }
+    }
+
+    root_ = unite(root_, build(std::make_move_iterator(sorted.begin()), std::make_move_iterator(sorted.end())), parallelDepth(sorted.size()));
+    if (root_ != nullptr) {
+        root_->color_ = BLACK;
+    }
+    updateBounds();
+
+    for (auto& e: keys) {
+        indexRefresh(e);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::remove(const std::vector<Key>& keys)
+{
+    std::vector<Key> sorted = keys;
+    std::sort(sorted.begin(), sorted.end(), compare_);
+    sorted.erase(std::unique(sorted.begin(), sorted.end(), [this](const Key& a, const Key& b) { return !compare_(a, b) && !compare_(b, a); }), sorted.end());
+
+    for (auto& e: sorted) {
+        if (indexed_) {
+            indexErase(e);
+        }
+        dropDeadlines(e);
+    }
+
+    root_ = subtract(root_, sorted, 0, (int)sorted.size() - 1, parallelDepth(sorted.size()));
+    if (root_ != nullptr) {
+        root_->color_ = BLACK;
+    }
+    updateBounds();
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::unite(BasicRBTree& other)
+{
+    if (&other == this) {
+        return;
+    }
+
+    // The merge below only replaces keys present here, so other must not repeat one either
+    if (policy_ == UNIQUE && other.policy_ == MULTI) {
+        other.keepNewest();
+    }
+
+    std::vector<Key> keys;
+    if (indexed_) {
+        for (Node* node = other.leftmost_; node != nullptr; node = next(node)) {
+            keys.push_back(node->key_);
+        }
+    }
+
+    // Under UNIQUE the tasks here keep their nodes but take the data and deadline of other
+    if (policy_ == UNIQUE && (!deadlines_.empty() || !other.deadlines_.empty())) {
+        for (Node* node = other.leftmost_; node != nullptr; node = next(node)) {
+            Node* existing = findNode(node->key_);
+            if (existing != nullptr) {
+                TimePoint deadline = node->deadline_;
+                other.retime(node, TimePoint::max());
+                retime(existing, deadline);
+            }
+        }
+    }
+    deadlines_.insert(other.deadlines_.begin(), other.deadlines_.end());
+    other.deadlines_.clear();
+
+    Node* second = other.root_;
+    other.root_ = nullptr;
+    other.updateBounds();
+    other.indexRebuild();
+
+    root_ = unite(root_, second, parallelDepth(countNodes(second)));
+    if (root_ != nullptr) {
+        root_->color_ = BLACK;
+    }
+    updateBounds();
+
+    for (auto& e: keys) {
+        indexRefresh(e);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::subtract(const BasicRBTree& other)
+{
+    std::vector<Key> keys;
+    std::vector<Node*> stack;
+    for (Node* node = other.root_; node != nullptr || !stack.empty(); node = node->right_) {
+        while (node != nullptr) {
+            stack.push_back(node);
+            node = node->left_;
+        }
+
+        node = stack.back();
+        stack.pop_back();
+        if (keys.empty() || compare_(keys.back(), node->key_)) {
+            keys.push_back(node->key_);
+        }
+    }
+
+    for (auto& e: keys) {
+        if (indexed_) {
+            indexErase(e);
+        }
+        dropDeadlines(e);
+    }
+
+    root_ = subtract(root_, keys, 0, (int)keys.size() - 1, parallelDepth(keys.size()));
+    if (root_ != nullptr) {
+        root_->color_ = BLACK;
+    }
+    updateBounds();
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::join(BasicRBTree& other)
+{
+    if (&other == this) {
+        return;
+    }
+
+    // Under UNIQUE only the last key here can occur in other, whose task wins as in unite
+    if (policy_ == UNIQUE) {
+        if (other.policy_ == MULTI) {
+            other.keepNewest();
+        }
+        if (rightmost_ != nullptr && other.leftmost_ != nullptr && equivalent(rightmost_->key_, other.leftmost_->key_)) {
+            Node* last = rightmost_;
+            unlink(last);
+            destroyNode(last);
+        }
+    }
+
+    // Only the appended tasks are indexed, in key order, so equal keys keep the oldest node
+    if (indexed_) {
+        for (Node* node = other.leftmost_; node != nullptr; node = next(node)) {
+            indexPut(node);
+        }
+    }
+
+    root_ = join(root_, other.root_);
+    deadlines_.insert(other.deadlines_.begin(), other.deadlines_.end());
+    other.deadlines_.clear();
+    other.root_ = nullptr;
+    other.updateBounds();
+    std::fill(other.indexSlots_.begin(), other.indexSlots_.end(), nullptr);
+    other.indexCount_ = 0;
+    if (root_ != nullptr) {
+        root_->color_ = BLACK;
+    }
+    updateBounds();
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::split(const Key& key, BasicRBTree& other)
+{
+    if (&other == this) {
+        return;
+    }
+
+    other.clear();
+    split(root_, key, false, root_, other.root_);
+
+    if (root_ != nullptr) {
+        root_->color_ = BLACK;
+    }
+    if (other.root_ != nullptr) {
+        other.root_->color_ = BLACK;
+    }
+
+    updateBounds();
+    other.updateBounds();
+
+    // Every task of a key moves together, so the index entries and deadlines move with them
+    if (indexed_ || other.indexed_ || !deadlines_.empty()) {
+        for (Node* node = other.leftmost_; node != nullptr; node = next(node)) {
+            if (indexed_) {
+                indexErase(node->key_);
+            }
+            if (other.indexed_) {
+                other.indexPut(node);
+            }
+            if (node->deadline_ != TimePoint::max()) {
+                deadlines_.erase({node->deadline_, node});
+                other.deadlines_.insert({node->deadline_, node});
+            }
+        }
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::clear()
+{
+    clear(root_);
+    root_ = nullptr;
+    leftmost_ = nullptr;
+    rightmost_ = nullptr;
+
+    std::fill(indexSlots_.begin(), indexSlots_.end(), nullptr);
+    indexCount_ = 0;
+    deadlines_.clear();
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+bool BasicRBTree<Key, Value, Compare, Allocator>::verify() const
+{
+    if (root_ == nullptr) {
+        return leftmost_ == nullptr && rightmost_ == nullptr && indexCount_ == 0 && deadlines_.empty();
+    }
+    if (root_->parent_ != nullptr || root_->color_ != BLACK) {
+        return false;
+    }
+
+    // Links, colors and black heights, depth first with the black count of each path
+    std::vector<std::pair<Node*, int>> stack = {{root_, 0}};
+    int blackHeight = -1;
+    size_t nodes = 0;
+
+    while (!stack.empty()) {
+        Node* node = stack.back().first;
+        int blacks = stack.back().second + (node->color_ == BLACK ? 1 : 0);
+        stack.pop_back();
+        nodes++;
+
+        for (Node* child : {node->left_, node->right_}) {
+            if (child == nullptr) {
+                if (blackHeight == -1) {
+                    blackHeight = blacks;
+                } else if (blackHeight != blacks) {
+                    return false;
+                }
+                continue;
+            }
+
+            if (child->parent_ != node || (node->color_ == RED && child->color_ == RED)) {
+                return false;
+            }
+            stack.push_back({child, blacks});
+        }
+    }
+
+    // Key order along the in-order sequence, which must start and end at the cached bounds
+    Node* first = root_;
+    while (first->left_ != nullptr) {
+        first = first->left_;
+    }
+    if (first != leftmost_) {
+        return false;
+    }
+
+    // The index must map every distinct key to the first node of its run and hold nothing else
+    size_t keys = 1;
+    if (indexed_ && indexFind(first->key_) != first) {
+        return false;
+    }
+
+    // Same for the deadline index and the tasks that have a deadline
+    size_t expiring = 0;
+    for (Node* node = first; node != nullptr; node = next(node)) {
+        if (node->deadline_ != TimePoint::max()) {
+            if (deadlines_.count({node->deadline_, node}) == 0) {
+                return false;
+            }
+            expiring++;
+        }
+    }
+    if (expiring != deadlines_.size()) {
+        return false;
+    }
+
+    Node* last = first;
+    for (Node* node = next(first); node != nullptr; node = next(node)) {
+        if (compare_(node->key_, last->key_) || (policy_ == UNIQUE && !compare_(last->key_, node->key_))) {
+            return false;
+        }
+        if (compare_(last->key_, node->key_)) {
+            keys++;
+            if (indexed_ && indexFind(node->key_) != node) {
+                return false;
+            }
+        }
+        last = node;
+        nodes--;
+    }
+
+    return last == rightmost_ && nodes == 1 && (!indexed_ || keys == indexCount_);
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::setHashIndex(bool enabled)
+{
+    if (enabled == indexed_) {
+        return;
+    }
+
+    indexed_ = enabled;
+    if (enabled) {
+        indexRebuild();
+    } else {
+        std::vector<Node*>().swap(indexSlots_);
+        indexCount_ = 0;
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+bool BasicRBTree<Key, Value, Compare, Allocator>::hasHashIndex() const
+{
+    return indexed_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::rotateL(Node* node, Node*& root)
+{
+    Node* child = node->right_;
+    node->right_ = child->left_;
+
+    if (node->right_ != nullptr) {
+        node->right_->parent_ = node;
+    }
+        
+    child->parent_ = node->parent_;
+    if (node->parent_ == nullptr) {
+        root = child;
+    } else if (node == node->parent_->left_) {
+        node->parent_->left_ = child;
+    } else {
+        node->parent_->right_ = child;
+    }
+        
+    child->left_ = node;
+    node->parent_ = child;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::rotateR(Node* node, Node*& root)
+{
+    Node* child = node->left_;
+    node->left_ = child->right_;
+
+    if (node->left_ != nullptr) {
+        node->left_->parent_ = node;
+    }
+            
+    child->parent_ = node->parent_;
+    if (node->parent_ == nullptr) {
+        root = child;
+    } else if (node == node->parent_->left_) {
+        node->parent_->left_ = child;
+    } else {
+        node->parent_->right_ = child;
+    }
+        
+    child->right_ = node;
+    node->parent_ = child;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::fixInsert(Node* node, Node*& root)
+{
+    Node* parent = nullptr;
+    Node* grandparent = nullptr;
+
+    while (node != root && node->color_ == RED && node->parent_->color_ == RED) {
+        parent = node->parent_;
+        grandparent = parent->parent_;
+
+        if (parent == grandparent->left_) {
+            Node* uncle = grandparent->right_;
+
+            if (uncle != nullptr && uncle->color_ == RED) {
+                grandparent->color_ = RED;
+                parent->color_ = BLACK;
+                uncle->color_ = BLACK;
+                node = grandparent;
+            } else {
+                if (node == parent->right_) {
+                    rotateL(parent, root);
+                    node = parent;
+                    parent = node->parent_;
+                }
+
+                rotateR(grandparent, root);
+                std::swap(parent->color_, grandparent->color_);
+                node = parent;
+            }
+        } else {
+            Node* uncle = grandparent->left_;
+
+            if (uncle != nullptr && uncle->color_ == RED) {
+                grandparent->color_ = RED;
+                parent->color_ = BLACK;
+                uncle->color_ = BLACK;
+                node = grandparent;
+            } else {
+                if (node == parent->left_) {
+                    rotateR(parent, root);
+                    node = parent;
+                    parent = node->parent_;
+                }
+
+                rotateL(grandparent, root);
+                std::swap(parent->color_, grandparent->color_);
+                node = parent;
+            }
+        }
+    }
+    
+    root->color_ = BLACK;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::fixRemove(Node* node, Node* parent)
+{
+    while (node != root_ && (node == nullptr || node->color_ == BLACK)) {
+        if (node == parent->left_) {
+            Node* sibling = parent->right_;
+
+            if (sibling->color_ == RED) {
+                std::swap(sibling->color_, parent->color_);
+                rotateL(parent, root_);
+                sibling = parent->right_;
+            }
+
+            if ((sibling->left_ == nullptr || sibling->left_->color_ == BLACK)
+                && (sibling->right_ == nullptr || sibling->right_->color_ == BLACK))
+            {
+                sibling->color_ = RED;
+                node = parent;
+                parent = node->parent_;
+            } else {
+                if (sibling->right_ == nullptr || sibling->right_->color_ == BLACK) {
+                    std::swap(sibling->left_->color_, sibling->color_);
+                    rotateR(sibling, root_);
+                    sibling = parent->right_;
+                }
+
+                std::swap(sibling->color_, parent->color_);
+
+                if (sibling->right_ != nullptr) {
+                    sibling->right_->color_ = BLACK;
+                }
+                
+                rotateL(parent, root_);
+                node = root_;
+            }
+        } else {
+            Node* sibling = parent->left_;
+
+            if (sibling->color_ == RED) {
+                std::swap(sibling->color_, parent->color_);
+                rotateR(parent, root_);
+                sibling = parent->left_;
+            }
+
+            if ((sibling->left_ == nullptr || sibling->left_->color_ == BLACK)
+                && (sibling->right_ == nullptr || sibling->right_->color_ == BLACK))
+            {
+                sibling->color_ = RED;
+                node = parent;
+                parent = node->parent_;
+            } else {
+                if (sibling->left_ == nullptr || sibling->left_->color_ == BLACK) {
+                    std::swap(sibling->right_->color_, sibling->color_);
+                    rotateL(sibling, root_);
+                    sibling = parent->left_;
+                }
+
+                std::swap(sibling->color_, parent->color_);
+
+                if (sibling->left_ != nullptr) {
+                    sibling->left_->color_ = BLACK;
+                }
+                    
+                rotateR(parent, root_);
+                node = root_;
+            }
+        }
+    }
+
+    if (node != nullptr) {
+        node->color_ = BLACK;
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::minKeyNode(Node* node)
+{
+    Node* current = node;
+    while (current->left_ != nullptr) {
+        current = current->left_;
+    }
+    
+    return current;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::next(Node* node) const
+{
+    if (node->right_ != nullptr) {
+        node = node->right_;
+        while (node->left_ != nullptr) {
+            node = node->left_;
+        }
+        return node;
+    }
+
+    while (node->parent_ != nullptr && node == node->parent_->right_) {
+        node = node->parent_;
+    }
+
+    return node->parent_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::prev(Node* node) const
+{
+    if (node->left_ != nullptr) {
+        node = node->left_;
+        while (node->right_ != nullptr) {
+            node = node->right_;
+        }
+        return node;
+    }
+
+    while (node->parent_ != nullptr && node == node->parent_->left_) {
+        node = node->parent_;
+    }
+
+    return node->parent_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::link(Node* node)
+{
+    Node* parent = nullptr;
+    Node* current = root_;
+
+    while (current != nullptr) {
+        parent = current;
+
+        if (compare_(node->key_, current->key_)) {
+            current = current->left_;
+        } else if (policy_ == UNIQUE && !compare_(current->key_, node->key_)) {
+            current->data_ = std::move(node->data_);
+            retime(current, node->deadline_);
+            destroyNode(node);
+            return;
+        } else {
+            current = current->right_;
+        }
+    }
+
+    node->color_ = RED;
+    node->left_ = nullptr;
+    node->right_ = nullptr;
+    node->parent_ = parent;
+
+    if (parent == nullptr) {
+        root_ = node;
+        leftmost_ = node;
+        rightmost_ = node;
+    } else if (compare_(node->key_, parent->key_)) {
+        parent->left_ = node;
+        if (parent == leftmost_) {
+            leftmost_ = node;
+        }
+    } else {
+        parent->right_ = node;
+        if (parent == rightmost_) {
+            rightmost_ = node;
+        }
+    }
+
+    fixInsert(node, root_);
+
+    if (indexed_) {
+        indexPut(node);
+    }
+    if (node->deadline_ != TimePoint::max()) {
+        deadlines_.insert({node->deadline_, node});
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::unlink(Node* node)
+{
+    if (indexed_) {
+        indexUnlink(node);
+    }
+    if (node->deadline_ != TimePoint::max()) {
+        deadlines_.erase({node->deadline_, node});
+    }
+
+    if (node == leftmost_) {
+        leftmost_ = next(node);
+    }
+    if (node == rightmost_) {
+        rightmost_ = prev(node);
+    }
+
+    Node* x = nullptr;
+    Node* y = nullptr;
+
+    // x may be nil, so its parent is tracked separately for the fix-up
+    Node* xParent = nullptr;
+
+    y = node;
+    Color yOriginalColor = y->color_;
+    if (node->left_ == nullptr) {
+        x = node->right_;
+        xParent = node->parent_;
+        transplant(node, node->right_);
+    } else if (node->right_ == nullptr) {
+        x = node->left_;
+        xParent = node->parent_;
+        transplant(node, node->left_);
+    } else {
+        y = minKeyNode(node->right_);
+        yOriginalColor = y->color_;
+        x = y->right_;
+        xParent = y;
+
+        if (y->parent_ != node) {
+            xParent = y->parent_;
+            transplant(y, y->right_);
+            y->right_ = node->right_;
+            y->right_->parent_ = y;
+        }
+
+        transplant(node, y);
+        y->left_ = node->left_;
+        y->left_->parent_ = y;
+        y->color_ = node->color_;
+    }
+
+    if (yOriginalColor == BLACK) {
+        fixRemove(x, xParent);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+bool BasicRBTree<Key, Value, Compare, Allocator>::pop(Node* node, Entry& res)
+{
+    if (node == nullptr) {
+        return false;
+    }
+
+    unlink(node);
+    res.key_ = std::move(node->key_);
+    res.data_ = std::move(node->data_);
+    destroyNode(node);
+
+    return true;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::updateBounds()
+{
+    leftmost_ = root_;
+    rightmost_ = root_;
+
+    while (leftmost_ != nullptr && leftmost_->left_ != nullptr) {
+        leftmost_ = leftmost_->left_;
+    }
+    while (rightmost_ != nullptr && rightmost_->right_ != nullptr) {
+        rightmost_ = rightmost_->right_;
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::transplant(Node* u, Node* v)
+{
+    if (u->parent_ == nullptr) {
+        root_ = v;
+    } else if (u == u->parent_->left_) {
+        u->parent_->left_ = v;
+    } else {
+        u->parent_->right_ = v;
+    }
+        
+    if (v != nullptr) {
+        v->parent_ = u->parent_;
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+template <typename It>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::build(It first, It last)
+{
+    if (first == last) {
+        return nullptr;
+    }
+
+    // Splitting at the middle keeps every leaf on the two deepest levels,
+    // so painting the deepest one red equalizes all black heights
+    int redDepth = 0;
+    for (size_t n = last - first; n > 1; n >>= 1) {
+        redDepth++;
+    }
+
+    Node* root = build(first, 0, (int)(last - first) - 1, 0, redDepth);
+    root->parent_ = nullptr;
+
+    return root;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+template <typename It>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::build(It first, int left, int right, int depth, int redDepth)
+{
+    if (left > right) {
+        return nullptr;
+    }
+
+    int middle = left + (right - left) / 2;
+    Node* node = createNode(first[middle].key_, first[middle].data_);
+    node->color_ = (depth == redDepth && depth > 0) ? RED : BLACK;
+
+    node->left_ = build(first, left, middle - 1, depth + 1, redDepth);
+    if (node->left_ != nullptr) {
+        node->left_->parent_ = node;
+    }
+
+    node->right_ = build(first, middle + 1, right, depth + 1, redDepth);
+    if (node->right_ != nullptr) {
+        node->right_->parent_ = node;
+    }
+
+    return node;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+int BasicRBTree<Key, Value, Compare, Allocator>::blackHeight(Node* node)
+{
+    int height = 0;
+    for (; node != nullptr; node = node->left_) {
+        if (node->color_ == BLACK) {
+            height++;
+        }
+    }
+
+    return height;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::join(Node* left, Node* middle, Node* right)
+{
+    // Black roots keep the black heights comparable and are always valid
+    if (left != nullptr) {
+        left->parent_ = nullptr;
+        left->color_ = BLACK;
+    }
+    if (right != nullptr) {
+        right->parent_ = nullptr;
+        right->color_ = BLACK;
+    }
+
+    int leftHeight = blackHeight(left);
+    int rightHeight = blackHeight(right);
+
+    middle->parent_ = nullptr;
+    middle->color_ = RED;
+
+    if (leftHeight == rightHeight) {
+        middle->left_ = left;
+        middle->right_ = right;
+        if (left != nullptr) {
+            left->parent_ = middle;
+        }
+        if (right != nullptr) {
+            right->parent_ = middle;
+        }
+
+        middle->color_ = BLACK;
+        return middle;
+    }
+
+    // Descend the spine of the taller tree to a black node of the shorter tree's
+    // black height, hang the red middle there and repair as after an insertion
+    Node* root = leftHeight > rightHeight ? left : right;
+    Node* parent = nullptr;
+    Node* current = root;
+    int height = std::max(leftHeight, rightHeight);
+    int target = std::min(leftHeight, rightHeight);
+
+    while (current != nullptr && (current->color_ == RED || height > target)) {
+        if (current->color_ == BLACK) {
+            height--;
+        }
+
+        parent = current;
+        current = leftHeight > rightHeight ? current->right_ : current->left_;
+    }
+
+    if (leftHeight > rightHeight) {
+        middle->left_ = current;
+        middle->right_ = right;
+        parent->right_ = middle;
+        if (right != nullptr) {
+            right->parent_ = middle;
+        }
+    } else {
+        middle->left_ = left;
+        middle->right_ = current;
+        parent->left_ = middle;
+        if (left != nullptr) {
+            left->parent_ = middle;
+        }
+    }
+
+    middle->parent_ = parent;
+    if (current != nullptr) {
+        current->parent_ = middle;
+    }
+
+    fixInsert(middle, root);
+
+    return root;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::join(Node* left, Node* right)
+{
+    if (left == nullptr) {
+        return right;
+    }
+    if (right == nullptr) {
+        return left;
+    }
+
+    Node* last = nullptr;
+    left = splitLast(left, last);
+
+    return join(left, last, right);
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::splitLast(Node* node, Node*& last)
+{
+    Node* left = node->left_;
+    Node* right = node->right_;
+    if (left != nullptr) {
+        left->parent_ = nullptr;
+    }
+
+    if (right == nullptr) {
+        last = node;
+        return left;
+    }
+
+    right->parent_ = nullptr;
+    right = splitLast(right, last);
+
+    return join(left, node, right);
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::split(Node* node, const Key& key, bool inclusive, Node*& left, Node*& right)
+{
+    if (node == nullptr) {
+        left = nullptr;
+        right = nullptr;
+        return;
+    }
+
+    Node* nodeLeft = node->left_;
+    Node* nodeRight = node->right_;
+    if (nodeLeft != nullptr) {
+        nodeLeft->parent_ = nullptr;
+    }
+    if (nodeRight != nullptr) {
+        nodeRight->parent_ = nullptr;
+    }
+
+    // Keys less than key (or equal to it when inclusive) go to the left part
+    bool toLeft = inclusive ? !compare_(key, node->key_) : compare_(node->key_, key);
+
+    if (toLeft) {
+        Node* rest = nullptr;
+        split(nodeRight, key, inclusive, rest, right);
+        left = join(nodeLeft, node, rest);
+    } else {
+        Node* rest = nullptr;
+        split(nodeLeft, key, inclusive, left, rest);
+        right = join(rest, node, nodeRight);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::unite(Node* first, Node* second, int depth)
+{
+    if (first == nullptr) {
+        return second;
+    }
+    if (second == nullptr) {
+        return first;
+    }
+
+    Node* firstLeft = first->left_;
+    Node* firstRight = first->right_;
+    if (firstLeft != nullptr) {
+        firstLeft->parent_ = nullptr;
+    }
+    if (firstRight != nullptr) {
+        firstRight->parent_ = nullptr;
+    }
+
+    Node* secondLeft = nullptr;
+    Node* secondRight = nullptr;
+    split(second, first->key_, false, secondLeft, secondRight);
+
+    if (policy_ == UNIQUE) {
+        Node* equal = nullptr;
+        split(secondRight, first->key_, true, equal, secondRight);
+
+        if (equal != nullptr) {
+            Node* last = nullptr;
+            equal = splitLast(equal, last);
+            first->data_ = std::move(last->data_);
+            destroyNode(last);
+            clear(equal);
+        }
+    }
+
+    Node* left = nullptr;
+    Node* right = nullptr;
+    if (depth > 0) {
+        std::future<Node*> leftPart = std::async(std::launch::async, [&]() {
+            return unite(firstLeft, secondLeft, depth - 1);
+        });
+        right = unite(firstRight, secondRight, depth - 1);
+        left = leftPart.get();
+    } else {
+        left = unite(firstLeft, secondLeft, 0);
+        right = unite(firstRight, secondRight, 0);
+    }
+
+    return join(left, first, right);
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::subtract(Node* node, const std::vector<Key>& keys, int left, int right, int depth)
+{
+    if (node == nullptr || left > right) {
+        return node;
+    }
+
+    int middle = left + (right - left) / 2;
+
+    Node* less = nullptr;
+    Node* rest = nullptr;
+    Node* equal = nullptr;
+    Node* greater = nullptr;
+    split(node, keys[middle], false, less, rest);
+    split(rest, keys[middle], true, equal, greater);
+    clear(equal);
+
+    if (depth > 0) {
+        std::future<Node*> lessPart = std::async(std::launch::async, [&]() {
+            return subtract(less, keys, left, middle - 1, depth - 1);
+        });
+        greater = subtract(greater, keys, middle + 1, right, depth - 1);
+        less = lessPart.get();
+    } else {
+        less = subtract(less, keys, left, middle - 1, 0);
+        greater = subtract(greater, keys, middle + 1, right, 0);
+    }
+
+    return join(less, greater);
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+int BasicRBTree<Key, Value, Compare, Allocator>::parallelDepth(size_t batchSize)
+{
+    // Small batches are cheaper to merge than to hand over to other threads
+    if (batchSize < (1 << 14)) {
+        return 0;
+    }
+
+    int depth = 0;
+    for (unsigned threads = std::thread::hardware_concurrency(); threads > 1; threads >>= 1) {
+        depth++;
+    }
+
+    return depth;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+size_t BasicRBTree<Key, Value, Compare, Allocator>::countNodes(Node* node)
+{
+    size_t res = 0;
+    std::vector<Node*> stack;
+    if (node != nullptr) {
+        stack.push_back(node);
+    }
+
+    while (!stack.empty()) {
+        Node* current = stack.back();
+        stack.pop_back();
+        res++;
+
+        if (current->left_ != nullptr) {
+            stack.push_back(current->left_);
+        }
+        if (current->right_ != nullptr) {
+            stack.push_back(current->right_);
+        }
+    }
+
+    return res;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::keepNewest()
+{
+    // Equal keys are in insertion order, so a task followed by an equal one is outdated
+    Node* node = leftmost_;
+    while (node != nullptr) {
+        Node* following = next(node);
+        if (following != nullptr && equivalent(node->key_, following->key_)) {
+            unlink(node);
+            destroyNode(node);
+        }
+        node = following;
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::clear(Node* node)
+{
+    // Rotating left children up flattens the tree into a right spine as it is freed,
+    // so any shape is destroyed in O(n) time and O(1) memory
+    while (node != nullptr) {
+        if (node->left_ != nullptr) {
+            Node* left = node->left_;
+            node->left_ = left->right_;
+            left->right_ = node;
+            node = left;
+        } else {
+            Node* right = node->right_;
+            destroyNode(node);
+            node = right;
+        }
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+template <typename K>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::findNode(const K& key) const
+{
+    Node* node = root_;
+    Node* res = nullptr;
+
+    while (node != nullptr) {
+        if (compare_(key, node->key_)) {
+            node = node->left_;
+        } else if (compare_(node->key_, key)) {
+            node = node->right_;
+        } else {
+            // Older equal tasks can only be further left
+            res = node;
+            if (policy_ == UNIQUE) {
+                break;
+            }
+            node = node->left_;
+        }
+    }
+
+    return res;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::lookup(const Key& key) const
+{
+    return indexed_ ? indexFind(key) : findNode(key);
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+bool BasicRBTree<Key, Value, Compare, Allocator>::equivalent(const Key& first, const Key& second) const
+{
+    return !compare_(first, second) && !compare_(second, first);
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+size_t BasicRBTree<Key, Value, Compare, Allocator>::indexSlot(const Key& key) const
+{
+    // Fibonacci hashing spreads weak hashes like the identity on int over the high bits
+    return (size_t)(((uint64_t)std::hash<Key>()(key) * 0x9E3779B97F4A7C15ull) >> indexShift_);
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+size_t BasicRBTree<Key, Value, Compare, Allocator>::indexProbe(const Key& key) const
+{
+    size_t mask = indexSlots_.size() - 1;
+    size_t slot = indexSlot(key);
+
+    while (indexSlots_[slot] != nullptr && !equivalent(indexSlots_[slot]->key_, key)) {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::indexFind(const Key& key) const
+{
+    return indexSlots_[indexProbe(key)];
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::indexPut(Node* node)
+{
+    // Load factor at most 0.7 keeps the probe sequences short
+    if ((indexCount_ + 1) * 10 > indexSlots_.size() * 7) {
+        indexResize(std::max<size_t>(16, indexSlots_.size() * 2));
+    }
+
+    size_t slot = indexProbe(node->key_);
+    if (indexSlots_[slot] == nullptr) {
+        indexSlots_[slot] = node;
+        indexCount_++;
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::indexEraseSlot(size_t slot)
+{
+    size_t mask = indexSlots_.size() - 1;
+    indexSlots_[slot] = nullptr;
+    indexCount_--;
+
+    // Backward shift: pull later entries of the cluster into the hole unless that
+    // would put them before their home slot, so no tombstones are needed
+    for (size_t current = (slot + 1) & mask; indexSlots_[current] != nullptr; current = (current + 1) & mask) {
+        size_t home = indexSlot(indexSlots_[current]->key_);
+        if (((current - home) & mask) >= ((current - slot) & mask)) {
+            indexSlots_[slot] = indexSlots_[current];
+            indexSlots_[current] = nullptr;
+            slot = current;
+        }
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::indexErase(const Key& key)
+{
+    size_t slot = indexProbe(key);
+    if (indexSlots_[slot] != nullptr) {
+        indexEraseSlot(slot);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::indexRefresh(const Key& key)
+{
+    Node* node = findNode(key);
+    size_t slot = indexProbe(key);
+
+    if (indexSlots_[slot] == nullptr) {
+        if (node != nullptr) {
+            indexPut(node);
+        }
+    } else if (node != nullptr) {
+        indexSlots_[slot] = node;
+    } else {
+        indexEraseSlot(slot);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::indexUnlink(Node* node)
+{
+    size_t slot = indexProbe(node->key_);
+    if (indexSlots_[slot] != node) {
+        return;
+    }
+
+    // The next task with the same key, if any, becomes the oldest one
+    Node* successor = next(node);
+    if (successor != nullptr && equivalent(successor->key_, node->key_)) {
+        indexSlots_[slot] = successor;
+    } else {
+        indexEraseSlot(slot);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::indexResize(size_t capacity)
+{
+    std::vector<Node*> slots(capacity, nullptr);
+    slots.swap(indexSlots_);
+
+    indexShift_ = 64;
+    for (size_t size = capacity; size > 1; size >>= 1) {
+        indexShift_--;
+    }
+
+    size_t mask = capacity - 1;
+    for (Node* node : slots) {
+        if (node != nullptr) {
+            size_t slot = indexSlot(node->key_);
+            while (indexSlots_[slot] != nullptr) {
+                slot = (slot + 1) & mask;
+            }
+            indexSlots_[slot] = node;
+        }
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::indexRebuild()
+{
+    if (!indexed_) {
+        return;
+    }
+
+    size_t nodes = countNodes(root_);
+    size_t capacity = 16;
+    while (capacity * 7 < nodes * 10) {
+        capacity *= 2;
+    }
+
+    indexSlots_.clear();
+    indexCount_ = 0;
+    indexResize(capacity);
+
+    // In key order, so each key keeps its oldest node
+    for (Node* node = leftmost_; node != nullptr; node = next(node)) {
+        indexPut(node);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::retime(Node* node, TimePoint deadline)
+{
+    if (node->deadline_ != TimePoint::max()) {
+        deadlines_.erase({node->deadline_, node});
+    }
+
+    node->deadline_ = deadline;
+    if (deadline != TimePoint::max()) {
+        deadlines_.insert({deadline, node});
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::dropDeadlines(const Key& key)
+{
+    if (deadlines_.empty()) {
+        return;
+    }
+
+    for (Node* node = findNode(key); node != nullptr && !compare_(key, node->key_); node = next(node)) {
+        retime(node, TimePoint::max());
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::evictLazily()
+{
+    // Only trees with deadlines pay for reading the clock
+    if (!deadlines_.empty()) {
+        evictExpired(Clock::now());
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+template <typename... Args>
+typename BasicRBTree<Key, Value, Compare, Allocator>::Node* BasicRBTree<Key, Value, Compare, Allocator>::createNode(Args&&... args)
+{
+    Node* node = NodeTraits::allocate(alloc_, 1);
+
+    try {
+        NodeTraits::construct(alloc_, node, std::forward<Args>(args)...);
+    } catch (...) {
+        NodeTraits::deallocate(alloc_, node, 1);
+        throw;
+    }
+
+    return node;
+}
+
+template <typename Key, typename Value, typename Compare, typename Allocator>
+void BasicRBTree<Key, Value, Compare, Allocator>::destroyNode(Node* node)
+{
+    NodeTraits::destroy(alloc_, node);
+    NodeTraits::deallocate(alloc_, node, 1);
+}
\ No newline at end of file
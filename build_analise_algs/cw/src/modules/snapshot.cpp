@@ -0,0 +1,200 @@
+#include "snapshot.h"
+#include "binary_io.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+const char magic[4] = {'R', 'B', 'T', 'S'};
+const uint32_t version = 3;
+
+// magic, version, task count, payload size, CRC, then the log sequence since version 2
+const size_t crcOffset = 4 + 4 + 8 + 8;
+const size_t headerSizeV1 = crcOffset + 4;
+const size_t headerSize = headerSizeV1 + 8;
+
+// Since version 3 the CRC covers the other header fields too, before only the payload
+uint32_t headerCrc(const unsigned char* header, uint64_t fileVersion)
+{
+    if (fileVersion < 3) {
+        return 0;
+    }
+
+    uint32_t crc = crc32(header, crcOffset);
+    return crc32(header + headerSizeV1, headerSize - headerSizeV1, crc);
+}
+
+}
+
+bool saveSnapshot(const std::string& path, const std::vector<Task>& tasks, uint64_t sequence)
+{
+    std::string payload;
+    for (auto& e: tasks) {
+        // The length field has 4 bytes, a longer value would corrupt the file
+        if (e.data_.size() > UINT32_MAX) {
+            return false;
+        }
+
+        putUint(payload, (uint32_t)e.key_, 4);
+        putUint(payload, e.data_.size(), 4);
+        payload += e.data_;
+    }
+
+    std::string header(magic, sizeof(magic));
+    putUint(header, version, 4);
+    putUint(header, tasks.size(), 8);
+    putUint(header, payload.size(), 8);
+    putUint(header, 0, 4);
+    putUint(header, sequence, 8);
+
+    uint32_t crc = headerCrc((const unsigned char*)header.data(), version);
+    crc = crc32((const unsigned char*)payload.data(), payload.size(), crc);
+    for (size_t i = 0; i < 4; i++) {
+        header[crcOffset + i] = (char)((crc >> (8 * i)) & 0xFF);
+    }
+
+    std::string tmpPath = path + ".tmp";
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool ok = writeAll(fd, header) && writeAll(fd, payload) && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+
+    syncParentDirectory(path);
+
+    return true;
+}
+
+namespace
+{
+
+template <typename Tree>
+bool saveTree(const std::string& path, Tree& tree, uint64_t sequence)
+{
+    std::vector<Task> vec;
+    tree.getData(vec);
+
+    return saveSnapshot(path, vec, sequence);
+}
+
+template <typename Tree>
+bool loadTree(const std::string& path, Tree& tree, uint64_t* sequence)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < headerSizeV1) {
+        close(fd);
+        return false;
+    }
+
+    size_t size = st.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    const unsigned char* data = (const unsigned char*)mapping;
+    uint64_t fileVersion = getUint(data + 4, 4);
+    uint64_t count = getUint(data + 8, 8);
+    uint64_t payloadSize = getUint(data + 16, 8);
+    size_t dataStart = fileVersion == 1 ? headerSizeV1 : headerSize;
+
+    bool ok = std::memcmp(data, magic, sizeof(magic)) == 0
+        && fileVersion >= 1 && fileVersion <= version
+        && size >= dataStart
+        && payloadSize == size - dataStart
+        && getUint(data + crcOffset, 4) == crc32(data + dataStart, payloadSize, headerCrc(data, fileVersion));
+
+    // Tasks keep pointing into the mapping until the tree has copied them
+    std::vector<BasicTask<int, std::string_view>> views;
+    if (ok) {
+        views.reserve(std::min<uint64_t>(count, payloadSize / 8));
+    }
+
+    const unsigned char* current = data + dataStart;
+    const unsigned char* end = data + size;
+
+    for (uint64_t i = 0; ok && i < count; i++) {
+        if (end - current < 8) {
+            ok = false;
+            break;
+        }
+
+        int key = (int)(uint32_t)getUint(current, 4);
+        uint64_t length = getUint(current + 4, 4);
+        current += 8;
+
+        if ((uint64_t)(end - current) < length) {
+            ok = false;
+            break;
+        }
+
+        views.push_back({key, std::string_view((const char*)current, length)});
+        current += length;
+    }
+
+    if (ok && current == end) {
+        auto byKey = [](const BasicTask<int, std::string_view>& a, const BasicTask<int, std::string_view>& b) {
+            return a.key_ < b.key_;
+        };
+        if (!std::is_sorted(views.begin(), views.end(), byKey)) {
+            std::stable_sort(views.begin(), views.end(), byKey);
+        }
+
+        tree.buildFromSorted(views.begin(), views.end());
+
+        if (sequence != nullptr) {
+            *sequence = fileVersion == 1 ? 0 : getUint(data + headerSizeV1, 8);
+        }
+    } else {
+        ok = false;
+    }
+
+    munmap(mapping, size);
+
+    return ok;
+}
+
+}
+
+bool saveSnapshot(const std::string& path, RBTree& rb_tree, uint64_t sequence)
+{
+    return saveTree(path, rb_tree, sequence);
+}
+
+bool saveSnapshot(const std::string& path, BPlusTree& tree, uint64_t sequence)
+{
+    return saveTree(path, tree, sequence);
+}
+
+bool loadSnapshot(const std::string& path, RBTree& rb_tree, uint64_t* sequence)
+{
+    return loadTree(path, rb_tree, sequence);
+}
+
+bool loadSnapshot(const std::string& path, BPlusTree& tree, uint64_t* sequence)
+{
+    return loadTree(path, tree, sequence);
+}
\ No newline at end of file
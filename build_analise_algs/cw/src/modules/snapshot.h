@@ -0,0 +1,29 @@
+#pragma once
+
+#include "rb_tree.h"
+#include "bplus_tree.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+Binary task tree snapshot, all integers little-endian:
+- header -- magic "RBTS", format version, task count, payload size, CRC-32 and, since
+  version 2, the last write-ahead log sequence number the snapshot covers. The CRC covers
+  the payload and, since version 3, every other header field
+- payload -- tasks in key order, each as key, data length and data bytes
+
+saveSnapshot writes a temporary file, syncs it and renames it over path, so a crash
+leaves either the old or the new snapshot. loadSnapshot maps the file, checks it and
+bulk-builds the tree straight from the mapped bytes; on failure the tree is left as is.
+saveSnapshot fails without touching path if a task's data is 4 GiB or longer.
+Both tree backends share the format.
+*/
+bool saveSnapshot(const std::string& path, RBTree& rb_tree, uint64_t sequence = 0);
+bool saveSnapshot(const std::string& path, BPlusTree& tree, uint64_t sequence = 0);
+// tasks must be sorted by key
+bool saveSnapshot(const std::string& path, const std::vector<Task>& tasks, uint64_t sequence = 0);
+
+bool loadSnapshot(const std::string& path, RBTree& rb_tree, uint64_t* sequence = nullptr);
+bool loadSnapshot(const std::string& path, BPlusTree& tree, uint64_t* sequence = nullptr);
@@ -0,0 +1,486 @@
+#include "task_store.h"
+#include "binary_io.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+TaskStore::TaskStore(const std::string& basePath, WalOptions options):
+    basePath_(basePath),
+    options_(options),
+    pendingCount_(0),
+    lastSequence_(0),
+    durableSequence_(0),
+    failed_(false),
+    stopping_(false),
+    fd_(-1),
+    segment_(0)
+{
+    load();
+
+    nextCheckpoint_ = std::chrono::steady_clock::now() + options_.checkpointInterval;
+    background_ = std::thread(&TaskStore::run, this);
+}
+
+TaskStore::~TaskStore()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    background_.join();
+
+    sync();
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+void TaskStore::insert(int key, std::string data)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    uint64_t sequence = append(INSERT, key, data);
+    tree_.insert(key, std::move(data));
+
+    waitDurable(lock, sequence);
+}
+
+void TaskStore::insert(const std::vector<Task>& tasks)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    uint64_t sequence = lastSequence_;
+    for (auto& e: tasks) {
+        sequence = append(INSERT, e.key_, e.data_);
+    }
+    tree_.insert(tasks);
+
+    waitDurable(lock, sequence);
+}
+
+bool TaskStore::remove(int key)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (!tree_.remove(key)) {
+        return false;
+    }
+
+    uint64_t sequence = append(REMOVE, key, "");
+
+    waitDurable(lock, sequence);
+
+    return true;
+}
+
+void TaskStore::clear()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    uint64_t sequence = append(CLEAR, 0, "");
+    tree_.clear();
+
+    waitDurable(lock, sequence);
+}
+
+std::string TaskStore::find(int key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const std::string* data = tree_.find(key);
+    return data == nullptr ? "" : *data;
+}
+
+bool TaskStore::contains(int key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tree_.contains(key);
+}
+
+bool TaskStore::tryGet(int key, std::string& out)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tree_.tryGet(key, out);
+}
+
+void TaskStore::getData(std::vector<Task>& res)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    tree_.getData(res);
+}
+
+uint64_t TaskStore::sequence()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastSequence_;
+}
+
+bool TaskStore::sync()
+{
+    return flush(std::numeric_limits<uint64_t>::max());
+}
+
+bool TaskStore::checkpoint()
+{
+    std::lock_guard<std::mutex> checkpointLock(checkpointMutex_);
+
+    uint64_t sequence = 0;
+    uint64_t segment = 0;
+
+    {
+        std::lock_guard<std::mutex> fileLock(fileMutex_);
+        std::string batch;
+        size_t count = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sequence = lastSequence_;
+            batch.swap(pending_);
+            count = pendingCount_;
+            pendingCount_ = 0;
+            nextCheckpoint_ = std::chrono::steady_clock::now() + options_.checkpointInterval;
+        }
+
+        // Later records go to a fresh segment, the current one is covered by the snapshot
+        bool ok = fd_ >= 0 && writeAll(fd_, batch) && fdatasync(fd_) == 0;
+        rollSegment();
+        ok = ok && fd_ >= 0;
+        segment = segment_;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (ok) {
+            durableSequence_ = std::max(durableSequence_, sequence);
+            failed_ = false;
+        } else {
+            restore(batch, count);
+            return false;
+        }
+    }
+
+    // The last snapshot and the closed segments hold every record up to sequence, so the new
+    // snapshot is rebuilt from them and writers never wait for it
+    TaskTree tree;
+    uint64_t last = 0;
+    if (!loadSnapshot(snapshotPath(), tree, &last)) {
+        std::error_code error;
+        if (std::filesystem::exists(snapshotPath(), error)) {
+            return false;
+        }
+        tree.clear();
+        last = 0;
+    }
+
+    std::vector<uint64_t> closed = listSegments();
+    for (uint64_t old : closed) {
+        if (old < segment) {
+            replay(segmentPath(old), tree, last);
+        }
+    }
+
+    if (!saveSnapshot(snapshotPath(), tree, last)) {
+        return false;
+    }
+
+    for (uint64_t old : closed) {
+        if (old < segment) {
+            unlink(segmentPath(old).c_str());
+        }
+    }
+    syncParentDirectory(snapshotPath());
+
+    return true;
+}
+
+bool TaskStore::recover()
+{
+    sync();
+
+    std::lock_guard<std::mutex> checkpointLock(checkpointMutex_);
+    std::lock_guard<std::mutex> fileLock(fileMutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // The disk must hold every update before the tree is dropped, otherwise the records
+    // stay pending and are retried on a fresh segment like any failed flush
+    if (fd_ < 0 || !writeAll(fd_, pending_) || fdatasync(fd_) != 0) {
+        rollSegment();
+        failed_ = true;
+        return false;
+    }
+    durableSequence_ = lastSequence_;
+    failed_ = false;
+    pending_.clear();
+    pendingCount_ = 0;
+
+    close(fd_);
+    fd_ = -1;
+
+    load();
+
+    return true;
+}
+
+std::string TaskStore::segmentPath(uint64_t segment) const
+{
+    return basePath_ + ".wal." + std::to_string(segment);
+}
+
+std::string TaskStore::snapshotPath() const
+{
+    return basePath_ + ".snapshot";
+}
+
+std::vector<uint64_t> TaskStore::listSegments() const
+{
+    std::filesystem::path base(basePath_);
+    std::filesystem::path dir = base.has_parent_path() ? base.parent_path() : std::filesystem::path(".");
+    std::string prefix = base.filename().string() + ".wal.";
+
+    std::vector<uint64_t> res;
+    std::error_code error;
+    for (auto& entry: std::filesystem::directory_iterator(dir, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) != 0 || name.size() == prefix.size()) {
+            continue;
+        }
+
+        std::string number = name.substr(prefix.size());
+        if (std::all_of(number.begin(), number.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            res.push_back(std::stoull(number));
+        }
+    }
+
+    std::sort(res.begin(), res.end());
+
+    return res;
+}
+
+void TaskStore::load()
+{
+    tree_.clear();
+
+    uint64_t sequence = 0;
+    if (!loadSnapshot(snapshotPath(), tree_, &sequence)) {
+        tree_.clear();
+        sequence = 0;
+    }
+    lastSequence_ = sequence;
+
+    std::vector<uint64_t> segments = listSegments();
+    for (uint64_t segment : segments) {
+        replay(segmentPath(segment), tree_, lastSequence_);
+    }
+    durableSequence_ = lastSequence_;
+
+    // Never append after a possibly torn tail
+    uint64_t next = segments.empty() ? 0 : segments.back() + 1;
+    if (!openSegment(next)) {
+        throw std::runtime_error("Cannot open write-ahead log " + segmentPath(next));
+    }
+}
+
+void TaskStore::replay(const std::string& path, TaskTree& tree, uint64_t& last)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::string log((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    // size and CRC of the body, then sequence, type, key, data length and data
+    const unsigned char* current = (const unsigned char*)log.data();
+    const unsigned char* end = current + log.size();
+
+    while (end - current >= 8) {
+        uint64_t size = getUint(current, 4);
+        uint32_t crc = (uint32_t)getUint(current + 4, 4);
+        const unsigned char* body = current + 8;
+
+        if (size < 17 || (uint64_t)(end - body) < size || crc32(body, size) != crc) {
+            break;
+        }
+
+        uint64_t sequence = getUint(body, 8);
+        RecordType type = (RecordType)body[8];
+        int key = (int)(uint32_t)getUint(body + 9, 4);
+        uint64_t length = getUint(body + 13, 4);
+        if (length != size - 17) {
+            break;
+        }
+
+        if (sequence > last) {
+            apply(tree, type, key, std::string((const char*)body + 17, length));
+            last = sequence;
+        }
+
+        current = body + size;
+    }
+}
+
+void TaskStore::apply(TaskTree& tree, RecordType type, int key, std::string data)
+{
+    if (type == INSERT) {
+        tree.insert(key, std::move(data));
+    } else if (type == REMOVE) {
+        tree.remove(key);
+    } else if (type == CLEAR) {
+        tree.clear();
+    }
+}
+
+uint64_t TaskStore::append(RecordType type, int key, const std::string& data)
+{
+    uint64_t sequence = ++lastSequence_;
+
+    std::string body;
+    putUint(body, sequence, 8);
+    body.push_back((char)type);
+    putUint(body, (uint32_t)key, 4);
+    putUint(body, data.size(), 4);
+    body += data;
+
+    putUint(pending_, body.size(), 4);
+    putUint(pending_, crc32((const unsigned char*)body.data(), body.size()), 4);
+    pending_ += body;
+
+    if (pendingCount_ == 0) {
+        pendingSince_ = std::chrono::steady_clock::now();
+    }
+    pendingCount_++;
+
+    if (pendingCount_ >= options_.syncEvery) {
+        changed_.notify_all();
+    }
+
+    return sequence;
+}
+
+void TaskStore::waitDurable(std::unique_lock<std::mutex>& lock, uint64_t sequence)
+{
+    if (!options_.waitForSync) {
+        return;
+    }
+
+    lock.unlock();
+    flush(sequence);
+}
+
+bool TaskStore::flush(uint64_t sequence)
+{
+    // Whoever gets the file first writes the records of every thread waiting behind it
+    std::lock_guard<std::mutex> fileLock(fileMutex_);
+
+    std::string batch;
+    size_t count = 0;
+    uint64_t last = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (durableSequence_ >= std::min(sequence, lastSequence_)) {
+            return !failed_;
+        }
+
+        batch.swap(pending_);
+        count = pendingCount_;
+        pendingCount_ = 0;
+        last = lastSequence_;
+    }
+
+    bool ok = fd_ >= 0 && writeAll(fd_, batch) && fdatasync(fd_) == 0;
+    if (!ok) {
+        rollSegment();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ok) {
+        durableSequence_ = std::max(durableSequence_, last);
+        failed_ = false;
+    } else {
+        restore(batch, count);
+    }
+
+    return !failed_;
+}
+
+void TaskStore::rollSegment()
+{
+    // The segment may end in a torn record, which stops its replay, so nothing is appended after it
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    openSegment(segment_ + 1);
+}
+
+void TaskStore::restore(std::string& batch, size_t count)
+{
+    // The batch is older than whatever was appended meanwhile
+    batch += pending_;
+    pending_.swap(batch);
+    if (pendingCount_ == 0) {
+        pendingSince_ = std::chrono::steady_clock::now();
+    }
+    pendingCount_ += count;
+    failed_ = true;
+}
+
+bool TaskStore::openSegment(uint64_t segment)
+{
+    int fd = open(segmentPath(segment).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    fd_ = fd;
+    segment_ = segment;
+    syncParentDirectory(segmentPath(segment));
+
+    return true;
+}
+
+void TaskStore::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stopping_) {
+        auto now = std::chrono::steady_clock::now();
+        bool checkpoints = options_.checkpointInterval.count() > 0;
+
+        if (pendingCount_ > 0 && (pendingCount_ >= options_.syncEvery || now >= pendingSince_ + options_.syncInterval)) {
+            lock.unlock();
+            bool ok = flush(std::numeric_limits<uint64_t>::max());
+            lock.lock();
+
+            // A failing disk is retried once per sync interval rather than in a busy loop
+            if (!ok && !stopping_) {
+                changed_.wait_for(lock, options_.syncInterval);
+            }
+            continue;
+        }
+
+        if (checkpoints && now >= nextCheckpoint_) {
+            lock.unlock();
+            checkpoint();
+            lock.lock();
+            continue;
+        }
+
+        auto wakeUp = std::chrono::steady_clock::time_point::max();
+        if (pendingCount_ > 0) {
+            wakeUp = pendingSince_ + options_.syncInterval;
+        }
+        if (checkpoints) {
+            wakeUp = std::min(wakeUp, nextCheckpoint_);
+        }
+
+        if (wakeUp == std::chrono::steady_clock::time_point::max()) {
+            changed_.wait(lock);
+        } else {
+            changed_.wait_until(lock, wakeUp);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "rb_tree.h"
+#include "bplus_tree.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+Write-ahead log settings
+- syncEvery -- the log is synced once this many records are pending...
+- syncInterval -- ...or once the oldest pending record is this old
+- waitForSync -- updates return only after their record is synced (group commit)
+- checkpointInterval -- period of background checkpoints, zero disables them
+*/
+struct WalOptions
+{
+    size_t syncEvery = 256;
+    std::chrono::milliseconds syncInterval {10};
+    bool waitForSync = true;
+    std::chrono::milliseconds checkpointInterval {60000};
+};
+
+// Tree backend of the store, build with -DTASK_STORE_BPLUS_TREE to use the B+-tree
+#ifdef TASK_STORE_BPLUS_TREE
+using TaskTree = BPlusTree;
+#else
+using TaskTree = RBTree;
+#endif
+
+/*
+Task tree persisted through a write-ahead log
+- <base>.snapshot -- latest checkpoint, see snapshot.h
+- <base>.wal.<n> -- log segments with every insert, remove and clear since then
+
+Each record is CRC-checked and numbered, recovery loads the snapshot and replays
+the newer records of every segment up to its first torn one. A checkpoint starts a new segment,
+rebuilds the snapshot from the last one and the closed segments without holding up updates,
+and then deletes the closed segments.
+A failed write leaves its records pending and moves to a new segment, so they are
+retried there and nothing is appended after the possibly torn tail.
+*/
+class TaskStore
+{
+public:
+    // Recovers the persisted state, throws std::runtime_error if the log cannot be opened
+    explicit TaskStore(const std::string& basePath, WalOptions options = WalOptions());
+    ~TaskStore();
+
+    TaskStore(const TaskStore&) = delete;
+    TaskStore& operator=(const TaskStore&) = delete;
+
+    void insert(int key, std::string data);
+    void insert(const std::vector<Task>& tasks);
+    // False if the key is missing, nothing is logged then
+    bool remove(int key);
+    void clear();
+
+    // Returns a copy, or an empty string if the key is missing
+    std::string find(int key);
+    bool contains(int key);
+    // Copies the data into out, reusing its storage, false if the key is missing
+    bool tryGet(int key, std::string& out);
+    void getData(std::vector<Task>& res);
+    // Number of the last logged record, each inserted task, remove and clear takes the next one
+    uint64_t sequence();
+
+    // Blocks until every update so far is durable, false if the last write failed
+    bool sync();
+    // False if a write fails or the last snapshot no longer loads, the log is kept then
+    bool checkpoint();
+
+    // Drops the in-memory tree and rebuilds it from disk. False if the pending updates
+    // cannot be written first, the tree is kept and they are retried then
+    bool recover();
+
+private:
+    enum RecordType
+    {
+        INSERT = 1,
+        REMOVE = 2,
+        CLEAR = 3
+    };
+
+    std::string basePath_;
+    WalOptions options_;
+
+    TaskTree tree_;
+
+    // Guards the tree, the pending records and the sequence numbers
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::string pending_;
+    size_t pendingCount_;
+    std::chrono::steady_clock::time_point pendingSince_;
+    uint64_t lastSequence_;
+    uint64_t durableSequence_;
+    bool failed_;
+    bool stopping_;
+
+    // Guards the segment file, taken before mutex_
+    std::mutex fileMutex_;
+    int fd_;
+    uint64_t segment_;
+
+    std::mutex checkpointMutex_;
+    std::chrono::steady_clock::time_point nextCheckpoint_;
+
+    std::thread background_;
+
+    std::string segmentPath(uint64_t segment) const;
+    std::string snapshotPath() const;
+    std::vector<uint64_t> listSegments() const;
+
+    void load();
+    // Applies the records of a segment newer than last to tree, advancing last
+    static void replay(const std::string& path, TaskTree& tree, uint64_t& last);
+    static void apply(TaskTree& tree, RecordType type, int key, std::string data);
+
+    // Appends a record to the pending batch, expects mutex_ held
+    uint64_t append(RecordType type, int key, const std::string& data);
+    void waitDurable(std::unique_lock<std::mutex>& lock, uint64_t sequence);
+
+    // Makes records up to sequence durable, batching whatever else is pending
+    bool flush(uint64_t sequence);
+    bool openSegment(uint64_t segment);
+    // Closes the current segment and opens the next one, expects fileMutex_ held
+    void rollSegment();
+    // Puts a batch that failed to write back in front of the pending records, expects mutex_ held
+    void restore(std::string& batch, size_t count);
+    void run();
+};
\ No newline at end of file
@@ -0,0 +1,269 @@
+#include "rb_tree.h"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+// Share of finds and inserts in the mixed phase, the rest are removes
+const int findPercent = 80;
+const int insertPercent = 10;
+const int maxMixedOps = 1000000;
+
+/*
+Zipfian ranks in [0, n) with skew theta, as generated by YCSB
+(Gray et al., "Quickly generating billion-record synthetic databases")
+*/
+class Zipfian
+{
+public:
+    Zipfian(uint64_t n, double theta):
+        n_(n),
+        theta_(theta),
+        alpha_(1.0 / (1.0 - theta)),
+        zetaN_(zeta(n, theta))
+    {
+        eta_ = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta(2, theta) / zetaN_);
+    }
+
+    uint64_t next(std::mt19937_64& rng)
+    {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        double uz = u * zetaN_;
+
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < 1.0 + std::pow(0.5, theta_)) {
+            return 1;
+        }
+
+        return std::min<uint64_t>(n_ - 1, (uint64_t)(n_ * std::pow(eta_ * u - eta_ + 1.0, alpha_)));
+    }
+
+private:
+    uint64_t n_;
+    double theta_;
+    double alpha_;
+    double zetaN_;
+    double eta_;
+
+    static double zeta(uint64_t n, double theta)
+    {
+        double res = 0;
+        for (uint64_t i = 1; i <= n; i++) {
+            res += 1.0 / std::pow((double)i, theta);
+        }
+        return res;
+    }
+};
+
+enum Distribution
+{
+    SEQUENTIAL,
+    UNIFORM,
+    ZIPFIAN
+};
+
+// Produces the keys of one workload, all drawn from the prefilled key set
+class KeySource
+{
+public:
+    KeySource(Distribution distribution, const std::vector<int>& keys):
+        distribution_(distribution),
+        keys_(keys),
+        rng_(keys.size()),
+        zipfian_(keys.size(), 0.99),
+        position_(0)
+    {}
+
+    int next()
+    {
+        if (distribution_ == SEQUENTIAL) {
+            return keys_[position_++ % keys_.size()];
+        }
+        if (distribution_ == UNIFORM) {
+            return keys_[rng_() % keys_.size()];
+        }
+        // keys_ is shuffled, so the hot ranks land on keys spread over the whole tree
+        return keys_[zipfian_.next(rng_)];
+    }
+
+private:
+    Distribution distribution_;
+    const std::vector<int>& keys_;
+    std::mt19937_64 rng_;
+    Zipfian zipfian_;
+    size_t position_;
+};
+
+// The same three operations on every container
+void insertTask(RBTree& tree, int key)
+{
+    tree.insert(key, "task");
+}
+
+bool findTask(RBTree& tree, int key)
+{
+    return tree.find(key) != nullptr;
+}
+
+void removeTask(RBTree& tree, int key)
+{
+    tree.remove(key);
+}
+
+void insertTask(std::map<int, std::string>& map, int key)
+{
+    map[key] = "task";
+}
+
+bool findTask(std::map<int, std::string>& map, int key)
+{
+    return map.find(key) != map.end();
+}
+
+void removeTask(std::map<int, std::string>& map, int key)
+{
+    map.erase(key);
+}
+
+void insertTask(std::multimap<int, std::string>& map, int key)
+{
+    map.emplace(key, "task");
+}
+
+bool findTask(std::multimap<int, std::string>& map, int key)
+{
+    return map.find(key) != map.end();
+}
+
+void removeTask(std::multimap<int, std::string>& map, int key)
+{
+    auto it = map.find(key);
+    if (it != map.end()) {
+        map.erase(it);
+    }
+}
+
+struct Result
+{
+    double fillOps;
+    double mixedOps;
+    double p50;
+    double p99;
+};
+
+template <typename Container>
+Result run(Container& container, Distribution distribution, const std::vector<int>& keys)
+{
+    Result res;
+
+    std::vector<int> fill = keys;
+    if (distribution == SEQUENTIAL) {
+        std::sort(fill.begin(), fill.end());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int key : fill) {
+        insertTask(container, key);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    res.fillOps = fill.size() / elapsed.count();
+
+    KeySource source(distribution, fill);
+    std::mt19937 rng(7);
+    int ops = std::min<int>(maxMixedOps, std::max<int>(keys.size(), 100000));
+    std::vector<double> latencies(ops);
+    size_t found = 0;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ops; i++) {
+        int key = source.next();
+        int kind = rng() % 100;
+
+        auto opStart = std::chrono::steady_clock::now();
+        if (kind < findPercent) {
+            found += findTask(container, key);
+        } else if (kind < findPercent + insertPercent) {
+            insertTask(container, key);
+        } else {
+            removeTask(container, key);
+        }
+        latencies[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - opStart).count();
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    res.mixedOps = ops / elapsed.count();
+
+    std::nth_element(latencies.begin(), latencies.begin() + ops / 2, latencies.end());
+    res.p50 = latencies[ops / 2];
+    std::nth_element(latencies.begin(), latencies.begin() + ops * 99 / 100, latencies.end());
+    res.p99 = latencies[ops * 99 / 100];
+
+    // Keeps the lookups from being optimized away
+    if (found == (size_t)-1) {
+        std::cout << std::endl;
+    }
+
+    return res;
+}
+
+void report(const std::string& workload, size_t size, const std::string& name, const Result& result)
+{
+    std::cout << std::setw(10) << workload << std::setw(10) << size << std::setw(15) << name
+              << std::setw(14) << (long long)result.fillOps << std::setw(14) << (long long)result.mixedOps
+              << std::setw(10) << (long long)result.p50 << std::setw(10) << (long long)result.p99 << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    // 10M keys take minutes, so the largest size is opt-in: ./rb_bench 10000000
+    size_t maxSize = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    std::cout << "mixed phase: " << findPercent << "% find, " << insertPercent << "% insert, "
+              << 100 - findPercent - insertPercent << "% remove; latencies include the clock reads" << std::endl;
+    std::cout << std::setw(10) << "workload" << std::setw(10) << "keys" << std::setw(15) << "container"
+              << std::setw(14) << "fill ops/s" << std::setw(14) << "mixed ops/s"
+              << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << std::endl;
+
+    const char* names[] = {"sequential", "uniform", "zipfian"};
+
+    for (size_t size = 1000; size <= maxSize; size *= 10) {
+        std::vector<int> keys(size);
+        std::iota(keys.begin(), keys.end(), 0);
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(size));
+
+        for (Distribution distribution : {SEQUENTIAL, UNIFORM, ZIPFIAN}) {
+            {
+                RBTree tree(UNIQUE);
+                report(names[distribution], size, "RBTree unique", run(tree, distribution, keys));
+            }
+            {
+                RBTree tree(UNIQUE);
+                tree.setHashIndex(true);
+                report(names[distribution], size, "RBTree indexed", run(tree, distribution, keys));
+            }
+            {
+                std::map<int, std::string> map;
+                report(names[distribution], size, "std::map", run(map, distribution, keys));
+            }
+            {
+                RBTree tree;
+                report(names[distribution], size, "RBTree multi", run(tree, distribution, keys));
+            }
+            {
+                std::multimap<int, std::string> map;
+                report(names[distribution], size, "std::multimap", run(map, distribution, keys));
+            }
+        }
+    }
+
+    return 0;
+}
\ No newline at end of file
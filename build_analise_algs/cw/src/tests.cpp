@@ -1,8 +1,23 @@
 #include "rb_tree.h"
+#include "concurrent_rb_tree.h"
+#include "persistent_rb_tree.h"
+#include "bplus_tree.h"
+#include "snapshot.h"
+#include "task_store.h"
 
 #include <iostream>
 #include <cassert>
 #include <algorithm>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <string_view>
+#include <fstream>
+#include <cstdio>
+#include <filesystem>
+#include <csignal>
+
+#include <sys/resource.h>
 
 int main() {
     RBTree rb_tree;
@@ -57,9 +72,423 @@ int main() {
     }
     assert(flag);
 
-    std::string data = rb_tree.find(8);
+    std::string data = *rb_tree.find(8);
     assert(data == "f");
 
+    std::vector<Task> sorted;
+    for (int i = 0; i < 100; i++) {
+        sorted.push_back({i * 2, std::to_string(i)});
+    }
+
+    rb_tree.buildFromSorted(sorted);
+    rb_tree.getData(vec);
+    assert(vec.size() == sorted.size());
+    for (size_t i = 0; i < vec.size(); i++) {
+        assert(vec[i].key_ == sorted[i].key_ && vec[i].data_ == sorted[i].data_);
+    }
+    assert(*rb_tree.find(42) == "21");
+
+    rb_tree.insert(41, "x");
+    rb_tree.remove(0);
+    rb_tree.getData(vec);
+    assert(vec.size() == sorted.size());
+    assert(vec[0].key_ == 2 && vec[20].key_ == 41);
+
+    rb_tree.clear();
+    rb_tree.insert({{5, "e"}, {1, "a"}, {9, "i"}, {3, "c"}, {7, "g"}});
+    rb_tree.remove(std::vector<int>{3, 9, 4});
+    rb_tree.getData(vec);
+    assert(vec.size() == 3 && vec[0].key_ == 1 && vec[1].key_ == 5 && vec[2].key_ == 7);
+
+    RBTree other;
+    rb_tree.split(5, other);
+    rb_tree.getData(vec);
+    assert(vec.size() == 1 && vec[0].key_ == 1);
+    other.getData(vec);
+    assert(vec.size() == 2 && vec[0].key_ == 5 && vec[1].key_ == 7);
+
+    rb_tree.join(other);
+    rb_tree.getData(vec);
+    assert(vec.size() == 3 && vec[2].data_ == "g");
+    other.getData(vec);
+    assert(vec.empty());
+
+    other.insert({{2, "b"}, {5, "e"}});
+    rb_tree.subtract(other);
+    rb_tree.getData(vec);
+    assert(vec.size() == 2 && vec[0].key_ == 1 && vec[1].key_ == 7);
+
+    rb_tree.unite(other);
+    rb_tree.getData(vec);
+    assert(vec.size() == 4 && vec[1].data_ == "b" && vec[2].data_ == "e");
+
+    rb_tree.clear();
+    for (int i = 0; i < 64; i++) {
+        rb_tree.insert(i, "x");
+    }
+    for (int i = 0; i < 64; i += 2) {
+        rb_tree.remove(i);
+    }
+    rb_tree.getData(vec);
+    assert(vec.size() == 32 && vec[0].key_ == 1 && vec[31].key_ == 63);
+
+    ConcurrentRBTree shared;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&shared, t]() {
+            for (int i = 0; i < 1000; i++) {
+                shared.insert(t * 1000 + i, "x");
+                assert(shared.find(t * 1000 + i) == "x");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    shared.getData(vec);
+    assert(vec.size() == 4000);
+
+    PersistentRBTree persistent;
+    for (int i = 0; i < 100; i++) {
+        persistent.insert(i, std::to_string(i));
+    }
+
+    PersistentRBTree::Snapshot frozen = persistent.snapshot();
+    std::thread reader([&frozen]() {
+        for (int i = 0; i < 100; i++) {
+            assert(*frozen.find(i) == std::to_string(i));
+        }
+    });
+    for (int i = 0; i < 100; i += 2) {
+        persistent.remove(i);
+    }
+    persistent.insert(7, "again");
+    reader.join();
+
+    frozen.getData(vec);
+    assert(vec.size() == 100 && vec[50].data_ == "50");
+    persistent.getData(vec);
+    assert(vec.size() == 51 && vec[3].key_ == 7 && vec[4].data_ == "again");
+    assert(persistent.find(50) == nullptr && frozen.find(100) == nullptr);
+
+    // Readers keep finding the stable keys while a writer replaces versions under them
+    std::atomic<bool> writing(true);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&persistent, &writing]() {
+            size_t reads = 0;
+            while (writing || reads < 1000) {
+                std::shared_ptr<const std::string> data = persistent.find(7);
+                bool found = data != nullptr && *data == "7";
+                assert(found);
+                reads++;
+            }
+        });
+    }
+    for (int i = 0; i < 20000; i++) {
+        persistent.insert(1000 + i % 100, "busy");
+        persistent.remove(1000 + (i + 50) % 100);
+    }
+    writing = false;
+    for (auto& thread : readers) {
+        thread.join();
+    }
+
+    persistent.clear();
+    persistent.insert(3, "first");
+    persistent.insert(3, "second");
+    persistent.insert(3, "");
+    assert(*persistent.find(3) == "first");
+    bool dropped = persistent.remove(3);
+    assert(dropped && *persistent.find(3) == "second");
+    persistent.remove(3);
+    assert(persistent.find(3) != nullptr && persistent.find(3)->empty());
+    dropped = persistent.remove(4);
+    assert(!dropped);
+
+    assert(rb_tree.find(1000) == nullptr);
+
+    BasicRBTree<std::string, std::unique_ptr<int>, std::less<>> owners;
+    owners.emplace("seven", new int(7));
+    owners.insert("eight", std::make_unique<int>(8));
+    assert(**owners.find(std::string_view("seven")) == 7);
+    assert(**owners.find("eight") == 8);
+    assert(owners.find("nine") == nullptr);
+    owners.remove("seven");
+    assert(owners.find("seven") == nullptr);
+
+    const std::string snapshotPath = "./tests_snapshot.bin";
+    rb_tree.clear();
+    rb_tree.insert({{3, "with spaces"}, {-1, "line\nbreak"}, {2, ""}});
+    bool saved = saveSnapshot(snapshotPath, rb_tree);
+    assert(saved);
+
+    RBTree restored;
+    bool loaded = loadSnapshot(snapshotPath, restored);
+    assert(loaded);
+    restored.getData(vec);
+    assert(vec.size() == 3 && vec[0].data_ == "line\nbreak" && vec[1].data_ == "" && vec[2].data_ == "with spaces");
+
+    {
+        std::fstream file(snapshotPath, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put('!');
+    }
+    loaded = loadSnapshot(snapshotPath, restored);
+    assert(!loaded);
+    restored.getData(vec);
+    assert(vec.size() == 3);
+
+    // A flipped bit in the log sequence of the header is caught as well
+    saved = saveSnapshot(snapshotPath, rb_tree, 5);
+    {
+        std::fstream file(snapshotPath, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(28);
+        file.put(4);
+    }
+    uint64_t sequence = 0;
+    loaded = loadSnapshot(snapshotPath, restored, &sequence);
+    assert(saved && !loaded && sequence == 0);
+    std::remove(snapshotPath.c_str());
+
+    rb_tree.clear();
+    rb_tree.insert({{2, "first"}, {1, "one"}, {2, "second"}});
+    rb_tree.insert(2, "third");
+    assert(rb_tree.count(2) == 3 && rb_tree.count(5) == 0 && *rb_tree.find(2) == "first");
+    rb_tree.getEqual(2, vec);
+    assert(vec.size() == 3 && vec[0].data_ == "first" && vec[2].data_ == "third");
+    rb_tree.remove(2);
+    assert(*rb_tree.find(2) == "second");
+    size_t erased = rb_tree.eraseAll(2);
+    size_t erasedAgain = rb_tree.eraseAll(2);
+    assert(erased == 2 && rb_tree.find(2) == nullptr && erasedAgain == 0);
+    rb_tree.getData(vec);
+    assert(vec.size() == 1 && vec[0].key_ == 1);
+
+    RBTree unique(UNIQUE);
+    unique.insert(1, "old");
+    unique.insert(1, "new");
+    unique.insert({{2, "a"}, {1, "batch"}, {2, "b"}});
+    assert(unique.count(1) == 1 && *unique.find(1) == "batch" && *unique.find(2) == "b");
+    RBTree incoming;
+    incoming.insert({{2, "c"}, {3, "d"}, {2, "e"}});
+    unique.unite(incoming);
+    unique.getData(vec);
+    assert(vec.size() == 3 && vec[1].data_ == "e" && vec[2].data_ == "d");
+    assert(unique.verify());
+    incoming.insert({{5, "f"}, {5, "g"}, {4, "h"}});
+    unique.unite(incoming);
+    assert(unique.count(5) == 1 && *unique.find(5) == "g" && unique.verify());
+    RBTree tail;
+    tail.insert({{5, "i"}, {6, "j"}, {6, "k"}});
+    unique.join(tail);
+    assert(unique.count(5) == 1 && *unique.find(5) == "i" && *unique.find(6) == "k" && unique.verify());
+    unique.buildFromSorted({{1, "l"}, {1, "m"}, {2, "n"}});
+    assert(unique.count(1) == 1 && *unique.find(1) == "m" && unique.verify());
+    bool replaced = unique.changePriority(1, 2);
+    assert(replaced && unique.count(2) == 1 && *unique.find(2) == "m" && !unique.contains(1));
+
+    std::vector<Task> many;
+    for (int i = 0; i < 1000000; i++) {
+        many.push_back({i, ""});
+    }
+    rb_tree.buildFromSorted(many);
+    for (int i = 0; i < 1000000; i += 3) {
+        rb_tree.remove(i);
+    }
+    assert(rb_tree.verify());
+    rb_tree.clear();
+    assert(rb_tree.verify());
+
+    rb_tree.insert(4, "four");
+    std::string out = "reused";
+    assert(rb_tree.contains(4) && !rb_tree.contains(5));
+    bool got = rb_tree.tryGet(4, out);
+    assert(got && out == "four");
+    got = rb_tree.tryGet(5, out);
+    assert(!got && out == "four");
+    bool removed = rb_tree.remove(4);
+    bool removedAgain = rb_tree.remove(4);
+    assert(removed && !removedAgain);
+
+    RBTree queue;
+    queue.insert({{5, "e"}, {1, "a"}, {3, "c"}, {1, "b"}});
+    assert(*queue.minKey() == 1 && *queue.min() == "a" && *queue.maxKey() == 5 && *queue.max() == "e");
+    Task top;
+    bool popped = queue.popMin(top);
+    assert(popped && top.key_ == 1 && top.data_ == "a");
+    popped = queue.popMax(top);
+    assert(popped && top.key_ == 5 && *queue.maxKey() == 3);
+    bool moved = queue.changePriority(1, 9);
+    assert(moved && *queue.max() == "b" && *queue.minKey() == 3);
+    assert(queue.verify());
+    moved = queue.changePriority(1, 0);
+    assert(!moved);
+    bool first = queue.popMin(top);
+    bool second = queue.popMin(top);
+    bool third = queue.popMin(top);
+    assert(first && second && !third && queue.min() == nullptr);
+    RBTree::NodeHandle handle = queue.makeNode(4, "handle");
+    {
+        RBTree::NodeHandle unused = queue.makeNode(6, "unused");
+    }
+    queue.insert(std::move(handle));
+    assert(*queue.find(4) == "handle" && !queue.contains(6) && queue.verify());
+
+    RBTree indexed;
+    indexed.insert({{2, "a"}, {2, "b"}, {7, "c"}});
+    indexed.setHashIndex(true);
+    for (int i = 0; i < 1000; i++) {
+        indexed.insert(i * 13, std::to_string(i));
+    }
+    assert(indexed.hasHashIndex() && *indexed.find(2) == "a" && *indexed.find(13) == "1");
+    removed = indexed.remove(2);
+    assert(removed && *indexed.find(2) == "b" && indexed.count(2) == 1);
+    indexed.insert(26, "dup");
+    erased = indexed.eraseAll(26);
+    assert(erased == 2 && !indexed.contains(26) && indexed.verify());
+    indexed.remove(std::vector<int>{13, 39});
+    got = indexed.tryGet(52, out);
+    assert(indexed.find(13) == nullptr && got && out == "4");
+    moved = indexed.changePriority(7, 13);
+    assert(moved && *indexed.find(13) == "c" && !indexed.contains(7));
+    RBTree upper;
+    indexed.split(6500, upper);
+    assert(indexed.find(6500) == nullptr && indexed.verify());
+    indexed.join(upper);
+    assert(indexed.find(6500) != nullptr && indexed.verify());
+    indexed.clear();
+    assert(indexed.find(2) == nullptr && indexed.verify());
+
+    RBTree expiring;
+    RBTree::TimePoint now = RBTree::Clock::now();
+    expiring.insert(1, "stale", now - std::chrono::seconds(1));
+    assert(expiring.count(1) == 1);
+    expiring.insert(2, "fresh", now + std::chrono::hours(1));
+    assert(expiring.count(1) == 0);
+    expiring.insert(1, "stale", now - std::chrono::seconds(1));
+    assert(expiring.contains(1) && *expiring.find(1) == "stale");
+    expiring.insert(3, "kept");
+    assert(!expiring.contains(1));
+    size_t evicted = expiring.evictExpired(now + std::chrono::hours(2));
+    assert(evicted == 1 && !expiring.contains(2));
+    assert(*expiring.find(3) == "kept" && expiring.verify());
+
+    BasicBPlusTree<int, std::string, std::less<int>, 4> bplus;
+    for (int i = 0; i < 200; i++) {
+        bplus.insert((i * 37) % 100, std::to_string(i));
+    }
+    bplus.getData(vec);
+    assert(vec.size() == 200);
+    assert(std::is_sorted(vec.begin(), vec.end(), [](const Task& a, const Task& b) { return a.key_ < b.key_; }));
+    assert(*bplus.find(37) == "1" && bplus.find(100) == nullptr);
+    for (int i = 0; i < 100; i += 2) {
+        bplus.remove(i);
+        bplus.remove(i);
+    }
+    bplus.getData(vec);
+    assert(vec.size() == 100 && vec[0].key_ == 1 && vec[1].key_ == 1 && bplus.find(50) == nullptr);
+
+    bplus.buildFromSorted(vec);
+    bplus.remove(99);
+    assert(bplus.find(99) != nullptr);
+    removed = bplus.remove(99);
+    removedAgain = bplus.remove(99);
+    assert(removed && !removedAgain);
+    got = bplus.tryGet(97, out);
+    assert(!bplus.contains(99) && bplus.contains(97) && got);
+    bplus.clear();
+    bplus.getData(vec);
+    assert(vec.empty());
+
+    const std::string storePath = "./tests_store";
+    WalOptions walOptions;
+    walOptions.checkpointInterval = std::chrono::milliseconds(0);
+    {
+        TaskStore store(storePath, walOptions);
+        store.insert({{5, "five"}, {1, "one"}, {3, "three"}});
+        store.remove(1);
+        store.insert(4, "four");
+    }
+    {
+        TaskStore store(storePath, walOptions);
+        store.getData(vec);
+        assert(vec.size() == 3 && vec[0].key_ == 3 && vec[1].key_ == 4 && vec[2].key_ == 5);
+        bool checkpointed = store.checkpoint();
+        assert(checkpointed);
+        store.clear();
+        store.insert(7, "seven");
+    }
+    {
+        std::ofstream torn(storePath + ".wal.2", std::ios::binary | std::ios::app);
+        torn << "torn";
+    }
+    {
+        TaskStore store(storePath, walOptions);
+        store.getData(vec);
+        assert(vec.size() == 1 && store.find(7) == "seven");
+        uint64_t logged = store.sequence();
+        store.insert(8, "eight");
+        assert(store.sequence() == logged + 1);
+        bool recovered = store.recover();
+        assert(recovered && store.find(8) == "eight" && store.find(5) == "");
+    }
+    {
+        // Writers keep going while the checkpoint rebuilds the snapshot from disk
+        TaskStore store(storePath, walOptions);
+        std::thread writer([&store]() {
+            for (int i = 100; i < 200; i++) {
+                store.insert(i, "w");
+            }
+        });
+        bool checkpointed = store.checkpoint();
+        writer.join();
+        assert(checkpointed);
+    }
+    {
+        TaskStore store(storePath, walOptions);
+        assert(store.find(199) == "w" && store.find(8) == "eight" && store.find(7) == "seven");
+    }
+    for (auto& entry: std::filesystem::directory_iterator(".")) {
+        if (entry.path().filename().string().rfind("tests_store.", 0) == 0) {
+            std::filesystem::remove(entry.path());
+        }
+    }
+
+    {
+        TaskStore store(storePath, walOptions);
+        store.insert(1, "before");
+
+        // The file size limit makes the next write fail halfway through its record
+        std::signal(SIGXFSZ, SIG_IGN);
+        rlimit limit;
+        getrlimit(RLIMIT_FSIZE, &limit);
+        rlimit small = limit;
+        small.rlim_cur = std::filesystem::file_size(storePath + ".wal.0") + 64;
+        setrlimit(RLIMIT_FSIZE, &small);
+
+        store.insert(2, std::string(1000, 'x'));
+        bool synced = store.sync();
+        assert(!synced && store.find(2).size() == 1000);
+        bool recovered = store.recover();
+        assert(!recovered && store.find(2).size() == 1000);
+
+        setrlimit(RLIMIT_FSIZE, &limit);
+        synced = store.sync();
+        assert(synced);
+        store.insert(3, "after");
+    }
+    {
+        TaskStore store(storePath, walOptions);
+        store.getData(vec);
+        assert(vec.size() == 3 && vec[1].data_.size() == 1000 && vec[2].data_ == "after");
+    }
+    for (auto& entry: std::filesystem::directory_iterator(".")) {
+        if (entry.path().filename().string().rfind("tests_store.", 0) == 0) {
+            std::filesystem::remove(entry.path());
+        }
+    }
+
     std::cout << "All tests passed" << std::endl;
 
     return 0;
@@ -0,0 +1,94 @@
+#include "rb_tree.h"
+#include "bplus_tree.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+struct Timings
+{
+    double insert;
+    double find;
+    double scan;
+    double remove;
+};
+
+double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+template <typename Tree>
+Timings run(const std::vector<int>& keys)
+{
+    Timings res;
+    Tree tree;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int key : keys) {
+        tree.insert(key, "task");
+    }
+    res.insert = elapsedMs(start);
+
+    // Lookups go in a different order than the inserts, so the cache is no help
+    std::vector<int> lookups(keys.rbegin(), keys.rend());
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int key : lookups) {
+        found += tree.find(key) != nullptr;
+    }
+    res.find = elapsedMs(start);
+
+    std::vector<Task> vec;
+    start = std::chrono::steady_clock::now();
+    tree.getData(vec);
+    res.scan = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int key : lookups) {
+        tree.remove(key);
+    }
+    res.remove = elapsedMs(start);
+
+    if (found != keys.size() || vec.size() != keys.size()) {
+        std::cout << "Benchmark lost tasks" << std::endl;
+    }
+
+    return res;
+}
+
+void report(const std::string& workload, const std::string& name, const Timings& timings)
+{
+    std::cout << std::setw(12) << workload << std::setw(8) << name << std::fixed << std::setprecision(1)
+              << std::setw(12) << timings.insert << std::setw(12) << timings.find
+              << std::setw(12) << timings.scan << std::setw(12) << timings.remove << std::endl;
+}
+
+int main()
+{
+    std::cout << std::setw(12) << "workload" << std::setw(8) << "tree" << std::setw(12) << "insert ms"
+              << std::setw(12) << "find ms" << std::setw(12) << "scan ms" << std::setw(12) << "remove ms" << std::endl;
+
+    for (int size : {100000, 1000000}) {
+        std::vector<int> sequential(size);
+        std::iota(sequential.begin(), sequential.end(), 0);
+
+        std::vector<int> random = sequential;
+        std::shuffle(random.begin(), random.end(), std::mt19937(size));
+
+        std::string suffix = " " + std::to_string(size / 1000) + "k";
+
+        report("seq" + suffix, "rb", run<RBTree>(sequential));
+        report("seq" + suffix, "b+", run<BPlusTree>(sequential));
+        report("rand" + suffix, "rb", run<RBTree>(random));
+        report("rand" + suffix, "b+", run<BPlusTree>(random));
+    }
+
+    return 0;
+}
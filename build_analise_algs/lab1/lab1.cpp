@@ -2,6 +2,21 @@
 #include <vector>
 #include <cmath>
 #include <stack>
+#include <deque>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <iomanip>
 
 #define DEBUG true
 
@@ -24,14 +39,12 @@ struct Square
 
 /*
 Struct representing a step in the partial solution
-- firstFreeRow -- the row where the first free cell was found
 - computed -- flag that shows if the square placement for current step was computed
 - topLeftFree -- coordinates of the first free cell (top left)
 - candidate size -- size of the current square for placement
 */
 struct SolutionStep
 {
-    int firstFreeRow; 
     bool computed;
 
     std::pair<int, int> topLeftFree;
@@ -39,39 +52,76 @@ struct SolutionStep
 };
 
 /*
-Struct representing a tabletop
-- grid -- a matrix of cells of the tabletop
+Struct representing a tabletop as a skyline
+Squares are always placed at the first free cell, so the free cells of every column form
+one vertical run: the search covers it from the top, the initial squares from the bottom
+- heights -- the first free row of each column
+- floors -- the row after the last free cell of each column, the column is full when it equals the height
 - squares -- all squares placed on the tabletop
-- size -- size of the side of the tabletop
+- width, height -- sizes of the sides of the tabletop
+- maxSide -- the largest square worth placing: one less than the side of a square tabletop, the shorter side of a rectangle
+- freeCells -- number of cells not covered yet
 
 Methods:
-- setState -- sets the value of the cells representing a square to the input value
+- setState -- covers or uncovers the cells of a square by moving the ends of the free runs of its columns
 - addSquare -- adds square to the tabletop
 - removeSquare -- removes square from the tabletop
 - findFirstFreeCell -- returns the first free cell coordinates on the tabletop or (-1, -1) if none were found
 - findMaxSquareSize -- returns the maximum size of the square that can be placed in specified corner
+- lowerBound -- returns the least number of squares that can still cover the free cells
 - getLastSquare -- returns last square added to the tabletop
-- printGrid -- prints the tabletop on screen
+- printGrid -- prints the tabletop into a stream
 */
 struct Tabletop
 {
-    std::vector<std::vector<int>> grid;
+    std::vector<int> heights;
+    std::vector<int> floors;
     std::vector<Square> squares;
-    int size;
+    int width;
+    int height;
+    int maxSide;
+    int freeCells;
 
     // tabletop initialization
-    Tabletop(int size) : size(size), grid(size, std::vector<int>(size, 0)) {}
-
-    // setting value of cells representing a square to the input value
-    void setState(Square& square, int squareNumber)
+    Tabletop(int width, int height) :
+        heights(width, 0),
+        floors(width, height),
+        width(width),
+        height(height),
+        maxSide(width == height ? width - 1 : std::min(width, height)),
+        freeCells(width * height)
+    {}
+
+    // covering or uncovering cells of a square
+    void setState(Square& square, bool covered)
     {
-        // iterating over rows
-        for (int i = square.y; i < square.y + square.size; i++)
+        freeCells += (covered ? -1 : 1) * square.size * square.size;
+
+        // iterating over columns
+        for (int j = square.x; j < square.x + square.size; j++)
         {
-            // iterating over cells in row
-            for (int j = square.x; j < square.x + square.size; j++)
+            if (covered)
             {
-                grid[i][j] = squareNumber;
+                // a square starting at the free run covers it from the top, otherwise it lies on its bottom
+                if (heights[j] == square.y)
+                {
+                    heights[j] = square.y + square.size;
+                }
+                else
+                {
+                    floors[j] = square.y;
+                }
+            }
+            else
+            {
+                if (heights[j] == square.y + square.size)
+                {
+                    heights[j] = square.y;
+                }
+                else
+                {
+                    floors[j] = square.y + square.size;
+                }
             }
         }
     }
@@ -81,8 +131,8 @@ struct Tabletop
     {
         squares.push_back(square);
 
-        // setting cells representing a square to it's number
-        setState(square, squares.size());
+        // covering cells of the square
+        setState(square, true);
     }
 
     // removing square from the vector and updating grid state
@@ -91,29 +141,31 @@ struct Tabletop
         Square square = squares.back();
         squares.pop_back();
 
-        // setting cells that represented a square to 0
-        setState(square, 0);
+        // uncovering cells that represented a square
+        setState(square, false);
     }
 
     // searching for the first free cell
-    std::pair<int, int> findFirstFreeCell(int firstFreeRow)
+    std::pair<int, int> findFirstFreeCell()
     {
-        // iterating over rows starting at firstFreeRow
-        for (int i = firstFreeRow; i < size; i++)
+        int column = -1;
+
+        // the lowest skyline point, the leftmost one among equal heights
+        for (int j = 0; j < width; j++)
         {
-            // iterating over cells in row
-            for (int j = 0; j < size; j++)
+            if (heights[j] < floors[j] && (column == -1 || heights[j] < heights[column]))
             {
-                // free cell found
-                if (!grid[i][j])
-                {
-                    return {j, i};
-                }
+                column = j;
             }
         }
 
         // no free cell found
-        return {-1, -1};
+        if (column == -1)
+        {
+            return {-1, -1};
+        }
+
+        return {column, heights[column]};
     }
 
     // calculating the maximum size of a square that can fit
@@ -123,32 +175,17 @@ struct Tabletop
         int x = cellCoordinates.first; 
         int y = cellCoordinates.second;
 
-        while (true)
+        // the square spans the run of columns at the same height, and as many rows as the shallowest of them
+        int depth = height - y;
+
+        while (x + maxSize < width && heights[x + maxSize] == y)
         {
-            // out of grid boundaries
-            if (x + maxSize >= size || y + maxSize >= size)
-            {
-                break;
-            }
+            depth = std::min(depth, floors[x + maxSize] - y);
 
-            // checking bottom row
-            for (int i = x; i <= x + maxSize; i++)
-            {
-                // collision found -- returning current value
-                if(grid[y + maxSize][i])
-                {
-                    return maxSize;
-                }
-            }
-   
-            // checking right column
-            for (int i = y; i <= y + maxSize; i++)
+            // collision found -- returning current value
+            if (depth <= maxSize)
             {
-                // collision found -- returning current value
-                if (grid[i][x + maxSize])
-                {
-                    return maxSize;
-                }
+                break;
             }
 
             // no collision found -- increasing size
@@ -158,71 +195,142 @@ struct Tabletop
         return maxSize;
     }
 
+    // estimating how many squares are still needed
+    int lowerBound()
+    {
+        // no square can be deeper than the deepest free run of a column
+        int deepest = 0;
+        for (int j = 0; j < width; j++)
+        {
+            deepest = std::max(deepest, floors[j] - heights[j]);
+        }
+
+        int side = std::min(deepest, maxSide);
+        if (side == 0)
+        {
+            return 0;
+        }
+
+        // even squares of the largest possible side need this many to cover the free area
+        return (freeCells + side * side - 1) / (side * side);
+    }
+
     // returning last square added to the tabletop
     Square& getLastSquare()
     {
         return squares.back();
     }
 
-    // printing the tabletop on screen
-    void printGrid()
+    // printing the tabletop into a stream
+    void printGrid(std::ostream& out)
     {
+        // restoring the number of the square that covers each cell
+        std::vector<std::vector<int>> grid(height, std::vector<int>(width, 0));
+        for (int k = 0; k < (int)squares.size(); k++)
+        {
+            for (int i = squares[k].y; i < squares[k].y + squares[k].size; i++)
+            {
+                for (int j = squares[k].x; j < squares[k].x + squares[k].size; j++)
+                {
+                    grid[i][j] = k + 1;
+                }
+            }
+        }
+
         // iterating over rows
-        for (int i = 0; i < size; i++)
+        for (int i = 0; i < height; i++)
         {
             // iterating over cells in row
-            for (int j = 0; j < size; j++)
+            for (int j = 0; j < width; j++)
             {
-                std::cout << "[" << grid[i][j] << "]";
+                out << "[" << grid[i][j] << "]";
             }
 
-            std::cout << "\n";
+            out << "\n";
         }
 
-        std::cout << "\n";
+        out << "\n";
     }
 };
 
 /*
-Struct for debugging purposes
-- debug -- is debugging enabled
+Struct for debugging purposes, enabled or disabled at compile time
+Disabled, every method is empty and its calls compile to nothing, so the search pays nothing for logging
+
+Methods:
+- log, mute, flush -- do nothing
+*/
+template <bool Enabled>
+struct Tracer
+{
+    void log(const char*) {}
+    void log(const char*, int) {}
+    void log(const char*, int, int) {}
+    void log(const char*, Square&) {}
+    void log(Tabletop&) {}
+
+    void mute() {}
+    void flush() {}
+};
+
+/*
+Enabled debugger, it collects the trace in memory and writes it on screen in large blocks
+- debug -- is logging enabled, turned off for solvers whose trace nobody reads
+- buffer -- trace collected since the last flush
+- limit -- size of the buffer that triggers a flush
 
 Methods:
-- log -- depending on input parametrs prints message on the screen
+- log -- depending on input parametrs adds message to the trace
+- mute -- turns logging off
+- flush -- writes the collected trace on screen
+- spill -- flushes the buffer once it reaches the limit
 */
-struct Debugger
+template <>
+struct Tracer<true>
 {
-    bool debug = DEBUG;
+    bool debug = true;
+    std::ostringstream buffer;
 
-    void log(const std::string& message)
+    static const std::streamoff limit = 1 << 16;
+
+    ~Tracer()
+    {
+        flush();
+    }
+
+    void log(const char* message)
     {
         if (debug)
         {
-            std::cout << message << "\n";
+            buffer << message << "\n";
+            spill();
         }
     }
 
-    void log(const std::string& message, int value)
+    void log(const char* message, int value)
     {
         if (debug)
         {
-            std::cout << message << ": " << value << "\n";
+            buffer << message << ": " << value << "\n";
+            spill();
         }
     }
 
-    void log(const std::string& message, int firstValue, int secondValue)
+    void log(const char* message, int firstValue, int secondValue)
     {
         if (debug)
         {
-            std::cout << message << ": (" << firstValue << ", " << secondValue << ")\n";
+            buffer << message << ": (" << firstValue << ", " << secondValue << ")\n";
+            spill();
         }
     }
 
-    void log(const std::string& message, Square& square)
+    void log(const char* message, Square& square)
     {
         if (debug)
         {
-            std::cout << message << " (" << square.x + 1 << ", " << square.y + 1 << ") with size " << square.size << "\n";
+            buffer << message << " (" << square.x + 1 << ", " << square.y + 1 << ") with size " << square.size << "\n";
+            spill();
         }
     }
 
@@ -230,31 +338,547 @@ struct Debugger
     {
         if (debug)
         {
-            tabletop.printGrid();
+            tabletop.printGrid(buffer);
+            spill();
+        }
+    }
+
+    void mute()
+    {
+        debug = false;
+    }
+
+    void flush()
+    {
+        std::cout << buffer.str();
+        buffer.str("");
+    }
+
+    void spill()
+    {
+        if (buffer.tellp() >= limit)
+        {
+            flush();
+        }
+    }
+};
+
+using Debugger = Tracer<DEBUG>;
+
+/*
+Struct representing the best solution found so far, shared by parallel workers
+- best -- number of squares of the best solution and index of the subproblem it came from,
+  packed into one word so that a smaller value is a better solution; on equal sizes the subproblem
+  that comes first in depth-first order wins, so the result is the one the sequential search finds
+- solution -- squares of the best solution
+- mutex -- guards solution
+- floor -- proven lower bound on the solution size; once the best solution reaches it, the
+  subproblems after the one it came from have nothing left to find
+- outsider -- subproblem index of solutions found outside the search, they lose every tie
+
+Methods:
+- pack -- packs a solution size and a subproblem index
+- prunes -- checks if a partial solution from the subproblem can no longer beat the best one
+- finished -- checks if the best solution reached the floor before the subproblem
+- offer -- replaces the best solution if the new one is better
+*/
+struct SharedBound
+{
+    std::atomic<uint64_t> best {UINT64_MAX};
+    std::vector<Square> solution {};
+    std::mutex mutex;
+    size_t floor = 0;
+
+    static const size_t outsider = 0xffffffff;
+
+    static uint64_t pack(size_t squares, size_t task)
+    {
+        return (uint64_t)squares << 32 | task;
+    }
+
+    bool prunes(size_t squares, size_t task)
+    {
+        return pack(squares, task) >= best.load(std::memory_order_relaxed) || finished(task);
+    }
+
+    bool finished(size_t task)
+    {
+        uint64_t current = best.load(std::memory_order_relaxed);
+
+        return (current >> 32) <= floor && task >= (current & outsider);
+    }
+
+    // returns true if the solution became the best one
+    bool offer(const std::vector<Square>& squares, size_t task)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (pack(squares.size(), task) >= best.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+
+        solution = squares;
+        best.store(pack(squares.size(), task), std::memory_order_relaxed);
+
+        return true;
+    }
+};
+
+// reasons for pruning a partial solution: it is no better than the best one by itself, with the squares
+// the lower bound says it still needs, or the best solution already reached the proven floor
+enum PruneReason
+{
+    INCUMBENT,
+    LOWER_BOUND,
+    FINISHED,
+    PRUNE_REASONS
+};
+
+/*
+Struct representing statistics of the search
+Every search counts into its own copy, which is added to the solver's one every 65536 nodes
+- nodes -- number of squares placed
+- prunes -- number of pruned partial solutions by reason
+- maxDepth -- the most squares on the tabletop at once, the deepest the stack of steps went
+- improvements -- seconds since the start and size of every new best solution
+- seconds -- duration of the search
+
+Methods:
+- merge -- adds the statistics of another search
+- report -- prints the statistics into a stream
+*/
+struct Statistics
+{
+    uint64_t nodes = 0;
+    uint64_t prunes[PRUNE_REASONS] = {};
+    size_t maxDepth = 0;
+    std::vector<std::pair<double, size_t>> improvements {};
+    double seconds = 0;
+
+    void merge(const Statistics& other)
+    {
+        nodes += other.nodes;
+        for (int i = 0; i < PRUNE_REASONS; i++)
+        {
+            prunes[i] += other.prunes[i];
+        }
+        maxDepth = std::max(maxDepth, other.maxDepth);
+        improvements.insert(improvements.end(), other.improvements.begin(), other.improvements.end());
+    }
+
+    void report(std::ostream& out)
+    {
+        // workers find their solutions in any order
+        std::sort(improvements.begin(), improvements.end());
+
+        out << "Nodes: " << nodes << "\n";
+        out << "Nodes per second: " << (uint64_t)(seconds > 0 ? nodes / seconds : 0) << "\n";
+        out << "Prunes: " << prunes[INCUMBENT] << " by the best solution, " << prunes[LOWER_BOUND] << " by the lower bound, "
+            << prunes[FINISHED] << " after reaching the floor\n";
+        out << "Max depth: " << maxDepth << "\n";
+        out << "Improvements:\n";
+        for (auto& improvement : improvements)
+        {
+            out << std::fixed << std::setprecision(3) << improvement.first << "s: " << improvement.second << " squares\n";
+        }
+        out << "Time: " << std::fixed << std::setprecision(3) << seconds << "s\n";
+    }
+};
+
+/*
+Struct distributing subproblems between worker threads
+- queues -- subproblem indices of every worker; the owner takes them from the front,
+  idle workers steal from the back of the others
+- mutexes -- one per queue
+
+Methods:
+- next -- returns the next subproblem for the worker or false if none are left
+*/
+struct TaskPool
+{
+    std::vector<std::deque<size_t>> queues;
+    std::vector<std::mutex> mutexes;
+
+    // dealing subproblems round-robin, so every worker starts with the earliest ones
+    TaskPool(size_t workers, size_t tasks) : queues(workers), mutexes(workers)
+    {
+        for (size_t i = 0; i < tasks; i++)
+        {
+            queues[i % workers].push_back(i);
+        }
+    }
+
+    bool next(size_t worker, size_t& task)
+    {
+        // own queue first
+        {
+            std::lock_guard<std::mutex> lock(mutexes[worker]);
+            if (!queues[worker].empty())
+            {
+                task = queues[worker].front();
+                queues[worker].pop_front();
+                return true;
+            }
+        }
+
+        // stealing from the other workers
+        for (size_t i = 1; i < queues.size(); i++)
+        {
+            size_t victim = (worker + i) % queues.size();
+
+            std::lock_guard<std::mutex> lock(mutexes[victim]);
+            if (!queues[victim].empty())
+            {
+                task = queues[victim].back();
+                queues[victim].pop_back();
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+/*
+Struct representing an on-disk table of solved tabletop sizes
+Every line holds the width and height, the number of squares and the x, y and size of each of them
+- path -- file of the table, new solutions are appended to it
+- solutions -- solutions by tabletop width and height
+
+Methods:
+- load -- reads the table, skipping lines that are malformed or do not cover the tabletop exactly
+- overlap -- checks whether two squares share a cell
+- find -- copies the solution for the size if the table has it
+- add -- stores a solution and appends it to the file
+*/
+struct SolutionTable
+{
+    std::string path;
+    std::map<std::pair<int, int>, std::vector<Square>> solutions;
+
+    SolutionTable(const std::string& path) : path(path)
+    {
+        load();
+    }
+
+    void load()
+    {
+        std::ifstream file(path);
+        std::string line;
+
+        while (std::getline(file, line))
+        {
+            std::istringstream stream(line);
+            int width = 0;
+            int height = 0;
+            int count = 0;
+            if (!(stream >> width >> height >> count) || width <= 0 || height <= 0 || count <= 0)
+            {
+                continue;
+            }
+
+            // squares that lie on the tabletop without overlapping cover it exactly when their areas add up to it;
+            // as in the search, a square tabletop is never covered by a single square
+            std::vector<Square> squares(count);
+            long long area = 0;
+            bool valid = true;
+            for (auto& square : squares)
+            {
+                valid = valid && (stream >> square.x >> square.y >> square.size)
+                    && square.size > 0 && square.x >= 0 && square.y >= 0
+                    && square.x <= width - square.size && square.y <= height - square.size
+                    && (width != height || square.size < width);
+                area += valid ? (long long)square.size * square.size : 0;
+            }
+
+            for (int i = 0; valid && i < count; i++)
+            {
+                for (int j = i + 1; valid && j < count; j++)
+                {
+                    valid = !overlap(squares[i], squares[j]);
+                }
+            }
+
+            if (valid && area == (long long)width * height)
+            {
+                solutions[{width, height}] = squares;
+            }
+        }
+    }
+
+    static bool overlap(const Square& a, const Square& b)
+    {
+        return a.x < b.x + b.size && b.x < a.x + a.size && a.y < b.y + b.size && b.y < a.y + a.size;
+    }
+
+    bool find(int width, int height, std::vector<Square>& squares)
+    {
+        auto it = solutions.find({width, height});
+        if (it == solutions.end())
+        {
+            return false;
+        }
+
+        squares = it->second;
+        return true;
+    }
+
+    void add(int width, int height, const std::vector<Square>& squares)
+    {
+        solutions[{width, height}] = squares;
+
+        std::ofstream file(path, std::ios::app);
+        file << width << " " << height << " " << squares.size();
+        for (auto& square : squares)
+        {
+            file << " " << square.x << " " << square.y << " " << square.size;
+        }
+        file << "\n";
+    }
+};
+
+/*
+Struct representing the free cells of a tabletop as an exact cover problem on dancing links (Knuth, Algorithm X)
+Every free cell is a column, every square that fits on the free cells is a row covering the columns of its cells.
+Nodes are kept in arrays, node 0 is the root and nodes 1 to the number of columns are the column headers;
+rows are added from the largest squares, so every column tries them first
+- left, right -- neighbours of a node in its row, of a header among the uncovered columns
+- up, down -- neighbours of a node in its column
+- column -- header of the column of a node
+- row -- row of a node
+- sizes -- number of rows left in every column
+- placements -- square of every row
+- freeCells -- number of cells not covered yet
+- largest -- side of the largest square left in the uncovered columns, found by shortestColumn
+
+Methods:
+- addRow -- adds a row for the square
+- cover -- removes a column and every row that covers it
+- uncover -- restores a column removed by the last cover
+- select -- covers the other columns of the row of a node, after the column of the node was covered
+- deselect -- undoes select
+- shortestColumn -- returns the uncovered column with the fewest rows or 0 if every column is covered,
+  the first row of every column being its largest square, it also finds the largest one left
+*/
+struct ExactCover
+{
+    std::vector<int> left;
+    std::vector<int> right;
+    std::vector<int> up;
+    std::vector<int> down;
+    std::vector<int> column;
+    std::vector<int> row;
+    std::vector<int> sizes;
+    std::vector<Square> placements;
+    int freeCells;
+    int largest = 0;
+
+    ExactCover(Tabletop& tabletop) :
+        freeCells(tabletop.freeCells)
+    {
+        // numbering the free cells, 0 marks covered ones
+        std::vector<int> cells(tabletop.width * tabletop.height, 0);
+        int columns = 0;
+        for (int y = 0; y < tabletop.height; y++)
+        {
+            for (int x = 0; x < tabletop.width; x++)
+            {
+                if (tabletop.heights[x] <= y && y < tabletop.floors[x])
+                {
+                    cells[y * tabletop.width + x] = ++columns;
+                }
+            }
+        }
+
+        // the root and the headers form one circular list
+        for (int i = 0; i <= columns; i++)
+        {
+            left.push_back(i == 0 ? columns : i - 1);
+            right.push_back(i == columns ? 0 : i + 1);
+            up.push_back(i);
+            down.push_back(i);
+            column.push_back(i);
+            row.push_back(-1);
+        }
+        sizes.resize(columns + 1, 0);
+
+        for (int size = tabletop.maxSide; size >= 1; size--)
+        {
+            for (int y = 0; y + size <= tabletop.height; y++)
+            {
+                for (int x = 0; x + size <= tabletop.width; x++)
+                {
+                    // the square fits if every cell under it is free
+                    std::vector<int> covered;
+                    for (int i = y; i < y + size; i++)
+                    {
+                        for (int j = x; j < x + size && cells[i * tabletop.width + j] != 0; j++)
+                        {
+                            covered.push_back(cells[i * tabletop.width + j]);
+                        }
+                    }
+
+                    if ((int)covered.size() == size * size)
+                    {
+                        addRow({x, y, size}, covered);
+                    }
+                }
+            }
+        }
+    }
+
+    void addRow(Square square, const std::vector<int>& columns)
+    {
+        int first = left.size();
+        for (size_t i = 0; i < columns.size(); i++)
+        {
+            int node = left.size();
+            int header = columns[i];
+
+            // linking the node at the bottom of its column
+            up.push_back(up[header]);
+            down.push_back(header);
+            down[up[header]] = node;
+            up[header] = node;
+
+            // and at the end of its row
+            left.push_back(i == 0 ? node : node - 1);
+            right.push_back(first);
+            if (i > 0)
+            {
+                right[node - 1] = node;
+                left[first] = node;
+            }
+
+            column.push_back(header);
+            row.push_back(placements.size());
+            sizes[header]++;
+        }
+
+        placements.push_back(square);
+    }
+
+    void cover(int header)
+    {
+        right[left[header]] = right[header];
+        left[right[header]] = left[header];
+
+        for (int i = down[header]; i != header; i = down[i])
+        {
+            for (int j = right[i]; j != i; j = right[j])
+            {
+                up[down[j]] = up[j];
+                down[up[j]] = down[j];
+                sizes[column[j]]--;
+            }
+        }
+    }
+
+    void uncover(int header)
+    {
+        for (int i = up[header]; i != header; i = up[i])
+        {
+            for (int j = left[i]; j != i; j = left[j])
+            {
+                sizes[column[j]]++;
+                up[down[j]] = j;
+                down[up[j]] = j;
+            }
+        }
+
+        right[left[header]] = header;
+        left[right[header]] = header;
+    }
+
+    void select(int node)
+    {
+        for (int j = right[node]; j != node; j = right[j])
+        {
+            cover(column[j]);
+        }
+
+        freeCells -= placements[row[node]].size * placements[row[node]].size;
+    }
+
+    void deselect(int node)
+    {
+        freeCells += placements[row[node]].size * placements[row[node]].size;
+
+        for (int j = left[node]; j != node; j = left[j])
+        {
+            uncover(column[j]);
+        }
+    }
+
+    int shortestColumn()
+    {
+        int best = 0;
+        largest = 0;
+        for (int header = right[0]; header != 0; header = right[header])
+        {
+            if (best == 0 || sizes[header] < sizes[best])
+            {
+                best = header;
+            }
+
+            if (sizes[header] > 0)
+            {
+                largest = std::max(largest, placements[row[down[header]]].size);
+            }
         }
+
+        return best;
     }
 };
 
-
 /*
 Struct for calculating and printing solution
-- solutionsStack -- stack with steps of a partial solution
-- bestSolution -- current best found solution
+- bestSolution -- optimal solution found by solve
 - debugger -- debugger for logging information
-- multiplier -- solutions for composite numbers are proportional to solutions for their smallest prime divisors
+- multiplier -- solutions for composite numbers are proportional to solutions for their smallest prime divisors,
+  solutions for rectangles to solutions for the rectangle divided by the greatest common divisor of its sides
+- threads -- number of worker threads, the search is sequential if it is 1
+- pruning -- enables the area lower bound, the diagonal symmetry breaking and the greedy initial solution
+- deepening -- searches with depth limits growing from the lower bound instead of a single branch and bound
+- exactCover -- searches the exact cover problem of the free cells with dancing links instead of the tabletop,
+  always on one thread and without the symmetry breaking
+- table -- table of solved sizes that is checked before searching and extended after it, if set
+- stats -- statistics of the search, statsMutex guards it
+- start -- time the solving started
+- progress -- seconds between progress lines on stderr, no lines if 0
+- lastProgress -- seconds since the start when the last progress line was printed
 
 Methods:
 - smallestPrime -- returns smallest prime divisor of the number or 0 if the number is prime
 - getTabletop -- returns a created tabletop of given size with first squares for optimization
+- candidateSize -- returns the largest square worth trying in the first free cell
+- elapsed -- returns seconds since the start
+- collect -- adds the statistics of a search to stats and prints a progress line when one is due
+- splitTasks -- collects the partial solutions of given depth in depth-first order as subproblems
+- search -- depth-first branch and bound from the current state of the tabletop
+- solveParallel -- runs search on the subproblems in a pool of worker threads
+- searchCover -- branch and bound over the exact cover problem, always branching on the cell with the fewest squares
+- greedySolution -- quickly builds a good tiling to start the search with
+- run -- searches with the chosen engine, sequentially or in parallel depending on threads
 - solve -- returns optimal solution for given tabletop size
 - outputSolution -- prints found optimal solution on screen
 */
 struct Solver
 {
-    std::stack<SolutionStep> solutionsStack {};
     std::vector<Square> bestSolution {};
     Debugger debugger;
     int multiplier = 1;
+    int threads = 1;
+    bool pruning = true;
+    bool deepening = false;
+    bool exactCover = false;
+    SolutionTable* table = nullptr;
+    Statistics stats {};
+    std::mutex statsMutex;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double progress = 0;
+    double lastProgress = 0;
 
     // searching for smallest prime divisor of the number
     int smallestPrime(int num)
@@ -274,13 +898,13 @@ struct Solver
     }
 
     // creates a tabletop of given size and puts first squares for optimization
-    Tabletop& getTabletop(int tabletopSize)
+    Tabletop getTabletop(int tabletopSize, int tabletopHeight)
     {
         // initializing tabletop
-        Tabletop& tabletop = *new Tabletop(tabletopSize);
+        Tabletop tabletop(tabletopSize, tabletopHeight);
 
-        // if the size is odd, make some initial placements
-        if (tabletopSize % 2 == 1)
+        // if the tabletop is a square and its size is odd, make some initial placements
+        if (tabletopSize == tabletopHeight && tabletopSize % 2 == 1)
         {
             // placing squares larger than this will be ineffective
             int threshold = tabletopSize / 2 + 1;
@@ -305,31 +929,95 @@ struct Solver
         return tabletop;
     }
 
-    // finding optimal solution for given tabletop size
-    void solve(int tabletopSize)
+    // limiting the square placed in the first free cell
+    int candidateSize(Tabletop& tabletop, std::pair<int, int> firstFreeCell)
     {
-        // searching for smallest prime divisor
-        int prime = smallestPrime(tabletopSize);
-        multiplier = prime ? tabletopSize / prime : 1;
+        int size = std::min(tabletop.findMaxSquareSize(firstFreeCell), tabletop.maxSide);
 
-        // reduce the size of a tabletop and solve the problem for a smaller size (if tabletopSize is a composite number)
-        if (multiplier != 1)
+        // The free area of a square tabletop is symmetric with respect to the main diagonal, so every
+        // tiling has a mirror image. Only tilings where the square right of the corner one is not smaller than
+        // the square below it are searched: the square at (0, c), c being the corner size, is capped by the one at (c, 0)
+        if (pruning && tabletop.width == tabletop.height && firstFreeCell.first == 0 && firstFreeCell.second > 0)
         {
-            debugger.log("Optimizing tabletop size from", tabletopSize);
+            int corner = firstFreeCell.second;
+            bool belowCorner = false;
+            for (auto& square : tabletop.squares)
+            {
+                belowCorner = belowCorner || (square.x == 0 && square.y == 0 && square.size == corner);
+            }
+
+            for (auto& square : tabletop.squares)
+            {
+                if (belowCorner && square.x == corner && square.y == 0)
+                {
+                    size = std::min(size, square.size);
+                }
+            }
         }
-        tabletopSize /= multiplier;
 
-        debugger.log("Solving for", tabletopSize);
+        return size;
+    }
 
-        // creating tabletop
-        Tabletop& tabletop = getTabletop(tabletopSize);
+    double elapsed()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // moving the counters of a search into the solver's statistics
+    void collect(Statistics& local, SharedBound& bound)
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+
+        stats.merge(local);
+        local = Statistics();
+
+        if (progress > 0 && elapsed() >= lastProgress + progress)
+        {
+            lastProgress = elapsed();
+
+            uint64_t best = bound.best.load(std::memory_order_relaxed) >> 32;
+            std::cerr << "[" << std::fixed << std::setprecision(1) << lastProgress << "s] nodes: " << stats.nodes
+                << ", nodes per second: " << (uint64_t)(stats.nodes / lastProgress) << ", max depth: " << stats.maxDepth
+                << ", best: " << (best == SharedBound::outsider ? 0 : best) << "\n";
+        }
+    }
+
+    // collecting placements of the next depth squares in the order search tries them
+    void splitTasks(Tabletop& tabletop, int depth, std::vector<Square>& prefix, std::vector<std::vector<Square>>& tasks)
+    {
+        std::pair<int, int> firstFreeCell = tabletop.findFirstFreeCell();
+
+        // covered tabletops and deep enough placements become subproblems
+        if (firstFreeCell.first == -1 || depth == 0)
+        {
+            tasks.push_back(prefix);
+            return;
+        }
+
+        for (int size = candidateSize(tabletop, firstFreeCell); size >= 1; size--)
+        {
+            Square square = {firstFreeCell.first, firstFreeCell.second, size};
+            tabletop.addSquare(square);
+            prefix.push_back(square);
+
+            splitTasks(tabletop, depth - 1, prefix, tasks);
+
+            prefix.pop_back();
+            tabletop.removeSquare();
+        }
+    }
+
+    // searching the tree of placements below the current state of the tabletop
+    template <typename Log>
+    void search(Tabletop& tabletop, SharedBound& bound, size_t task, Log& debugger)
+    {
+        std::stack<SolutionStep> solutionsStack;
+        Statistics local;
 
         // adding the inital step of solutions
-        SolutionStep initialStep = {0, false, {0, 0}, 0};
+        SolutionStep initialStep = {false, {0, 0}, 0};
         solutionsStack.push(initialStep);
 
-        debugger.log("START");
-
         // until we run out of steps in solutions
         while (!solutionsStack.empty())
         {
@@ -340,11 +1028,22 @@ struct Solver
             debugger.log(TABLETOP_STATE_MESSAGE);
             debugger.log(tabletop);
 
-            // prune the step if partial solution already worse than current best
-            if (!bestSolution.empty() && tabletop.squares.size() >= bestSolution.size())
+            // prune the step if partial solution already worse than current best, counting the squares it still needs
+            int needed = pruning ? tabletop.lowerBound() : 0;
+            if (bound.prunes(tabletop.squares.size() + needed, task))
             {
                 debugger.log("Prunning step of sub-optimal partial solution");
 
+                // the reason is only worked out for pruned steps
+                if (bound.finished(task))
+                {
+                    local.prunes[FINISHED]++;
+                }
+                else
+                {
+                    local.prunes[bound.prunes(tabletop.squares.size(), task) ? INCUMBENT : LOWER_BOUND]++;
+                }
+
                 // going to previous step
                 solutionsStack.pop();
 
@@ -366,7 +1065,7 @@ struct Solver
             if (!topStep.computed)
             {
                 // searching for first free cell
-                std::pair<int, int> firstFreeCell = tabletop.findFirstFreeCell(topStep.firstFreeRow);
+                std::pair<int, int> firstFreeCell = tabletop.findFirstFreeCell();
 
                 // if no free cells found -- tabletop is covered
                 if (firstFreeCell.first == -1)
@@ -374,11 +1073,10 @@ struct Solver
                     debugger.log("Tabletop fully covered");
 
                     // if current solution is better then current best
-                    if (bestSolution.empty() || tabletop.squares.size() < bestSolution.size())
+                    if (bound.offer(tabletop.squares, task))
                     {
                         debugger.log("New best solution");
-
-                        bestSolution = tabletop.squares;
+                        local.improvements.push_back({elapsed(), tabletop.squares.size()});
                     }
 
                     // going to previous step
@@ -400,7 +1098,7 @@ struct Solver
 
                 // calculating maximum size of a fitting square
                 topStep.topLeftFree = firstFreeCell;
-                topStep.candidateSize = std::min(tabletop.findMaxSquareSize(firstFreeCell), tabletopSize - 1);
+                topStep.candidateSize = candidateSize(tabletop, firstFreeCell);
                 topStep.computed = true;
 
                 debugger.log("Free cell", topStep.topLeftFree.first + 1, topStep.topLeftFree.second + 1);
@@ -413,6 +1111,13 @@ struct Solver
                 topStep.candidateSize--;
                 Square newSquare = {topStep.topLeftFree.first, topStep.topLeftFree.second, currentSize};
                 tabletop.addSquare(newSquare);
+                local.maxDepth = std::max(local.maxDepth, tabletop.squares.size());
+
+                // sampling the clock for progress lines only every 65536 nodes
+                if ((++local.nodes & 0xffff) == 0)
+                {
+                    collect(local, bound);
+                }
 
                 debugger.log(SQUARE_PLACEMENT_MESSAGE, newSquare);
                 debugger.log(TABLETOP_STATE_MESSAGE);
@@ -420,7 +1125,6 @@ struct Solver
                 
                 // adding a step of a new partial solution
                 SolutionStep newStep;
-                newStep.firstFreeRow = topStep.topLeftFree.second;
                 newStep.computed = false;
                 solutionsStack.push(newStep);
 
@@ -445,12 +1149,282 @@ struct Solver
             }
         }
 
+        collect(local, bound);
+    }
+
+    // splitting the top levels of the tree into subproblems and solving them on worker threads
+    void solveParallel(Tabletop& tabletop, SharedBound& bound)
+    {
+        // deepening the split until every worker has plenty of subproblems to balance
+        std::vector<std::vector<Square>> tasks;
+        for (int depth = 1; depth <= tabletop.width * tabletop.height; depth++)
+        {
+            std::vector<Square> prefix;
+            std::vector<std::vector<Square>> deeper;
+            splitTasks(tabletop, depth, prefix, deeper);
+
+            if (deeper.size() == tasks.size())
+            {
+                break;
+            }
+            tasks.swap(deeper);
+
+            if (tasks.size() >= 32 * (size_t)threads)
+            {
+                break;
+            }
+        }
+
+        debugger.log("Subproblems", tasks.size());
+
+        TaskPool pool(threads, tasks.size());
+        std::vector<std::thread> workers;
+
+        for (int i = 0; i < threads; i++)
+        {
+            workers.emplace_back([&, i]()
+            {
+                // workers interleave, so they do not log
+                Tracer<false> quiet;
+
+                size_t task;
+                while (pool.next(i, task))
+                {
+                    // every worker replays the placements of the subproblem on its own copy of the tabletop
+                    Tabletop local = tabletop;
+                    for (auto& square : tasks[task])
+                    {
+                        local.addSquare(square);
+                    }
+
+                    search(local, bound, task, quiet);
+                }
+            });
+        }
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    // covering the cell with the fewest fitting squares by each of them in turn
+    template <typename Log>
+    void searchCover(ExactCover& matrix, std::vector<Square>& squares, SharedBound& bound, Statistics& local, Log& debugger)
+    {
+        // every column covered -- tabletop is covered
+        if (matrix.right[0] == 0)
+        {
+            debugger.log("Tabletop fully covered");
+
+            if (bound.offer(squares, 0))
+            {
+                debugger.log("New best solution");
+                local.improvements.push_back({elapsed(), squares.size()});
+            }
+
+            return;
+        }
+
+        int header = matrix.shortestColumn();
+
+        // a cell no square fits in is a dead end
+        if (matrix.sizes[header] == 0)
+        {
+            return;
+        }
+
+        // the same pruning as in search, with the largest square left
+        int area = matrix.largest * matrix.largest;
+        size_t needed = pruning ? (matrix.freeCells + area - 1) / area : 0;
+        if (bound.prunes(squares.size() + needed, 0))
+        {
+            if (bound.finished(0))
+            {
+                local.prunes[FINISHED]++;
+            }
+            else
+            {
+                local.prunes[bound.prunes(squares.size(), 0) ? INCUMBENT : LOWER_BOUND]++;
+            }
+
+            return;
+        }
+
+        matrix.cover(header);
+
+        for (int node = matrix.down[header]; node != header; node = matrix.down[node])
+        {
+            matrix.select(node);
+            squares.push_back(matrix.placements[matrix.row[node]]);
+            local.maxDepth = std::max(local.maxDepth, squares.size());
+
+            debugger.log(SQUARE_PLACEMENT_MESSAGE, squares.back());
+
+            if ((++local.nodes & 0xffff) == 0)
+            {
+                collect(local, bound);
+            }
+
+            searchCover(matrix, squares, bound, local, debugger);
+
+            debugger.log(SQUARE_REMOVAL_MESSAGE, squares.back());
+
+            squares.pop_back();
+            matrix.deselect(node);
+        }
+
+        matrix.uncover(header);
+    }
+
+    // tiling greedily with the largest squares after every possible corner square, keeping the best tiling
+    std::vector<Square> greedySolution(Tabletop& tabletop)
+    {
+        std::vector<Square> best;
+        std::pair<int, int> corner = tabletop.findFirstFreeCell();
+        if (corner.first == -1)
+        {
+            return tabletop.squares;
+        }
+
+        for (int cornerSize = candidateSize(tabletop, corner); cornerSize >= 1; cornerSize--)
+        {
+            Tabletop local = tabletop;
+            Square square = {corner.first, corner.second, cornerSize};
+            local.addSquare(square);
+
+            for (std::pair<int, int> cell = local.findFirstFreeCell(); cell.first != -1; cell = local.findFirstFreeCell())
+            {
+                Square next = {cell.first, cell.second, candidateSize(local, cell)};
+                local.addSquare(next);
+            }
+
+            if (best.empty() || local.squares.size() < best.size())
+            {
+                best = local.squares;
+            }
+        }
+
+        return best;
+    }
+
+    void run(Tabletop& tabletop, SharedBound& bound)
+    {
+        if (exactCover)
+        {
+            ExactCover matrix(tabletop);
+            std::vector<Square> squares = tabletop.squares;
+            Statistics local;
+
+            searchCover(matrix, squares, bound, local, debugger);
+            collect(local, bound);
+        }
+        else if (threads > 1)
+        {
+            solveParallel(tabletop, bound);
+        }
+        else
+        {
+            search(tabletop, bound, 0, debugger);
+        }
+    }
+
+    // finding optimal solution for given tabletop size, the tabletop is a square if the height is 0
+    void solve(int tabletopSize, int tabletopHeight = 0)
+    {
+        start = std::chrono::steady_clock::now();
+
+        if (tabletopHeight == 0 || tabletopHeight == tabletopSize)
+        {
+            // searching for smallest prime divisor
+            int prime = smallestPrime(tabletopSize);
+            multiplier = prime ? tabletopSize / prime : 1;
+        }
+        else
+        {
+            // a tiling of the rectangle divided by the common divisor scales up to the whole rectangle
+            multiplier = std::gcd(tabletopSize, tabletopHeight);
+        }
+
+        // reduce the size of a tabletop and solve the problem for a smaller size (if tabletopSize is a composite number)
+        if (multiplier != 1)
+        {
+            debugger.log("Optimizing tabletop size from", tabletopSize);
+        }
+        tabletopSize /= multiplier;
+        tabletopHeight = tabletopHeight == 0 ? tabletopSize : tabletopHeight / multiplier;
+
+        if (tabletopSize == tabletopHeight)
+        {
+            debugger.log("Solving for", tabletopSize);
+        }
+        else
+        {
+            debugger.log("Solving for", tabletopSize, tabletopHeight);
+        }
+
+        // solved sizes are only looked up
+        if (table != nullptr && table->find(tabletopSize, tabletopHeight, bestSolution))
+        {
+            debugger.log("Solution found in table");
+            return;
+        }
+
+        // creating tabletop
+        Tabletop tabletop = getTabletop(tabletopSize, tabletopHeight);
+        // no tiling can use fewer squares than this
+        size_t floor = pruning ? tabletop.squares.size() + tabletop.lowerBound() : 0;
+
+        debugger.log("START");
+
+        if (deepening)
+        {
+            // only tilings of at most limit squares are searched, the first limit that has one is optimal
+            for (size_t limit = std::max<size_t>(floor, 1); bestSolution.empty(); limit++)
+            {
+                debugger.log("Depth limit", limit);
+
+                SharedBound bound;
+                bound.best = SharedBound::pack(limit + 1, 0);
+                bound.floor = limit;
+                run(tabletop, bound);
+
+                bestSolution = bound.solution;
+            }
+        }
+        else
+        {
+            SharedBound bound;
+            bound.floor = floor;
+
+            // an early incumbent prunes the first descents; equal tilings of the search still replace it
+            if (pruning)
+            {
+                bound.offer(greedySolution(tabletop), SharedBound::outsider);
+                debugger.log("Greedy solution", bound.solution.size());
+                stats.improvements.push_back({elapsed(), bound.solution.size()});
+            }
+
+            run(tabletop, bound);
+
+            bestSolution = bound.solution;
+        }
+
         debugger.log("END");
+        stats.seconds = elapsed();
+
+        if (table != nullptr)
+        {
+            table->add(tabletopSize, tabletopHeight, bestSolution);
+        }
     }
 
     // printing found optimal solution on screen
     void outputSolution()
     {
+        // the trace goes before the answer
+        debugger.flush();
+
         std::cout << bestSolution.size();
 
         for (auto& square : bestSolution)
@@ -462,11 +1436,166 @@ struct Solver
     }
 };
 
-int main()
+// solving every prime size up to bound that the table lacks, one size per worker thread
+void precompute(SolutionTable& table, int bound, int threads)
+{
+    std::vector<int> sizes;
+    for (int size = bound; size >= 2; size--)
+    {
+        std::vector<Square> known;
+        if (Solver().smallestPrime(size) == 0 && !table.find(size, size, known))
+        {
+            sizes.push_back(size);
+        }
+    }
+
+    // the largest sizes take the longest, so they are started first
+    std::atomic<size_t> nextSize {0};
+    std::mutex tableMutex;
+    std::vector<std::thread> workers;
+
+    for (int i = 0; i < threads; i++)
+    {
+        workers.emplace_back([&]()
+        {
+            for (size_t job = nextSize++; job < sizes.size(); job = nextSize++)
+            {
+                Solver solver;
+                solver.debugger.mute();
+                solver.solve(sizes[job]);
+
+                std::lock_guard<std::mutex> lock(tableMutex);
+                table.add(sizes[job], sizes[job], solver.bestSolution);
+                std::cout << sizes[job] << ": " << solver.bestSolution.size() << "\n";
+            }
+        });
+    }
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+// timing the tabletop search and the exact cover search on every size up to bound
+void benchmark(int bound)
+{
+    std::cout << "N squares search exact-cover winner\n";
+
+    for (int size = 2; size <= bound; size++)
+    {
+        double seconds[2];
+        size_t squares = 0;
+
+        for (int engine = 0; engine < 2; engine++)
+        {
+            Solver solver;
+            solver.debugger.mute();
+            solver.exactCover = engine == 1;
+
+            auto start = std::chrono::steady_clock::now();
+            solver.solve(size);
+            seconds[engine] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            squares = solver.bestSolution.size();
+        }
+
+        std::cout << size << " " << squares << std::fixed << std::setprecision(4) << " " << seconds[0] << " " << seconds[1]
+            << " " << (seconds[0] <= seconds[1] ? "search" : "exact-cover") << "\n" << std::flush;
+    }
+}
+
+int main(int argc, char* argv[])
 {
+    Solver solver;
+    bool reportStats = false;
+    std::string tablePath;
+    int precomputeBound = 0;
+    int benchmarkBound = 0;
+
+    // "--threads K" runs the search on K worker threads, 0 takes one per core,
+    // "--no-pruning" turns off the lower bound, symmetry breaking and greedy start,
+    // "--deepening" searches with growing depth limits, "--stats" prints statistics of the search on stderr,
+    // "--progress S" prints a progress line on stderr every S seconds,
+    // "--table PATH" answers from a table of solved sizes and extends it, "--precompute B" fills the table up to B,
+    // "--exact-cover" searches with dancing links, "--benchmark B" times both engines on every size up to B
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--threads" && i + 1 < argc)
+        {
+            int threads = std::atoi(argv[++i]);
+            solver.threads = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+        }
+        else if (arg == "--no-pruning")
+        {
+            solver.pruning = false;
+        }
+        else if (arg == "--deepening")
+        {
+            solver.deepening = true;
+        }
+        else if (arg == "--stats")
+        {
+            reportStats = true;
+        }
+        else if (arg == "--progress" && i + 1 < argc)
+        {
+            solver.progress = std::atof(argv[++i]);
+        }
+        else if (arg == "--table" && i + 1 < argc)
+        {
+            tablePath = argv[++i];
+        }
+        else if (arg == "--precompute" && i + 1 < argc)
+        {
+            precomputeBound = std::atoi(argv[++i]);
+        }
+        else if (arg == "--exact-cover")
+        {
+            solver.exactCover = true;
+        }
+        else if (arg == "--benchmark" && i + 1 < argc)
+        {
+            benchmarkBound = std::atoi(argv[++i]);
+        }
+    }
+
+    std::unique_ptr<SolutionTable> table;
+    if (!tablePath.empty())
+    {
+        table.reset(new SolutionTable(tablePath));
+        solver.table = table.get();
+    }
+
+    if (precomputeBound > 0)
+    {
+        if (!table)
+        {
+            std::cerr << "--precompute needs --table\n";
+            return 1;
+        }
+
+        precompute(*table, precomputeBound, std::max(1, solver.threads));
+        return 0;
+    }
+
+    if (benchmarkBound > 0)
+    {
+        benchmark(benchmarkBound);
+        return 0;
+    }
+
+    // "N" is a square tabletop, "N M" a rectangle N wide and M high
     int N;
+    int M = 0;
     std::cin >> N;
-    Solver solver;
-    solver.solve(N);
+    std::cin >> M;
+    solver.solve(N, M);
     solver.outputSolution();
+
+    if (reportStats)
+    {
+        solver.stats.report(std::cerr);
+    }
 }
@@ -1,93 +1,112 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <sstream>
 
+#define DEBUG true
 #define INF 100000000
 
 /*
 Class used for debugging logs, prints crucial info
+Enabled or disabled at compile time, disabled every method is empty and its calls compile to nothing
 */
-class Debugger 
-{ 
-private:
-    bool debug = true;
-    int size;
+template <bool Enabled>
+class Tracer
+{
 public:
-    Debugger(int size) :
-        size(size)
+    Tracer(int size)
     {}
 
-    void logMsg(const std::string& msg) 
+    void logMsg(const char* msg) {}
+    void logCost(const char* msg, const int cost) {}
+    void logCity(const char* startMsg, int city, const char* endMsg) {}
+    void logMask(const char* startMsg, const int mask, const char* endMsg) {}
+    void flush() {}
+};
+
+/*
+Enabled logs are collected in memory and written on screen in large blocks
+*/
+template <>
+class Tracer<true>
+{
+private:
+    int size;
+    std::ostringstream buffer;
+
+    static const std::streamoff limit = 1 << 16;
+
+    // writing the logs out once the buffer grows large
+    void spill()
     {
-        if (!debug) 
+        if (buffer.tellp() >= limit)
         {
-            return;
+            flush();
         }
+    }
+
+public:
+    Tracer(int size) :
+        size(size)
+    {}
 
-        std::cout << msg << "\n";
+    ~Tracer()
+    {
+        flush();
     }
 
-    void logCost(const std::string& msg, const int cost) 
+    void logMsg(const char* msg)
     {
-        if (!debug)
-        {
-            return;
-        }
+        buffer << msg << "\n";
+        spill();
+    }
 
-        if (cost < INF) 
+    void logCost(const char* msg, const int cost)
+    {
+        if (cost < INF)
         {
-            std::cout << msg << cost << "\n";
+            buffer << msg << cost << "\n";
         }
-        else 
+        else
         {
-            std::cout << msg << "INF" << "\n";
+            buffer << msg << "INF" << "\n";
         }
+        spill();
     }
 
-    void logCity(const std::string& startMsg, int city, const std::string& endMsg)
+    void logCity(const char* startMsg, int city, const char* endMsg)
     {
-        if (!debug) 
-        {
-            return;
-        }    
-        std::cout << startMsg << city << endMsg;
+        buffer << startMsg << city << endMsg;
+        spill();
     }
 
-    void logMask(const std::string& startMsg, const int mask, const std::string& endMsg)
+    void logMask(const char* startMsg, const int mask, const char* endMsg)
     {
-        if (!debug)
-        {
-            return;
-        }
-
-        std::cout << startMsg;
+        buffer << startMsg;
 
-        std::vector<int> bitPositions;
-        for (int i = 0; i < sizeof(int) * 8; i++) 
+        // cities whose bits are not set
+        for (int i = 0; i < size; i++)
         {
-            if (mask & (1 << i)) 
+            if (!(mask & (1 << i)))
             {
-                bitPositions.push_back(i);
+                buffer << i << " ";
             }
         }
 
-        std::reverse(bitPositions.begin(), bitPositions.end());
-
-        for(int i = 0; i < size; i++)
-        {
-            if (i == bitPositions[bitPositions.size() - 1])
-            {
-                bitPositions.pop_back();
-                continue;
-            }
-
-            std::cout << i << " ";
-        }
+        buffer << endMsg;
+        spill();
+    }
 
-        std::cout << endMsg;
+    // writing the collected logs on screen, so that they go before the answer
+    void flush()
+    {
+        std::cout << buffer.str();
+        buffer.str("");
     }
 };
 
+using Debugger = Tracer<DEBUG>;
+
 class Solver
 {    
 private:
@@ -129,6 +148,7 @@ public:
         if (costMatrix.size() == 1)
         {
             dbg.logMsg("FINISH\n");
+            dbg.flush();
 
             std::cout << "0\n0\n" ;
             return;
@@ -137,6 +157,7 @@ public:
         // find the best cost 
         int cost = findCost();
         dbg.logMsg("FINISH\n");
+        dbg.flush();
         
         // path wasn't found (no hamiltonian cycle)
         if (cost >= INF)
@@ -149,6 +170,7 @@ public:
         std::vector<int> way = getWay();
 
         dbg.logMsg("ANSWER:");
+        dbg.flush();
 
         // print results
         std::cout << cost << "\n";
@@ -1,59 +1,89 @@
 #include <iostream>
 #include <vector>
+#include <sstream>
 
+#define DEBUG true
 #define INF 10000000
 
 /*
 Class used for debugging logs, prints crucial info
+Enabled or disabled at compile time, disabled every method is empty and its calls compile to nothing
 */
-class Debugger
+template <bool Enabled>
+class Tracer
+{
+public:
+    void logMsg(const char* msg) {}
+    void log(const char* startMsg, const float cost, const char* endMsg) {}
+    void logPath(const std::vector<int>& path) {}
+    void flush() {}
+};
+
+/*
+Enabled logs are collected in memory and written on screen in large blocks
+*/
+template <>
+class Tracer<true>
 {
 private:
-    bool debug = true;
+    std::ostringstream buffer;
 
-public:
-    void logMsg(const std::string& msg) 
+    static const std::streamoff limit = 1 << 16;
+
+    // writing the logs out once the buffer grows large
+    void spill()
     {
-        if (!debug) 
+        if (buffer.tellp() >= limit)
         {
-            return;
+            flush();
         }
+    }
 
-        std::cout << msg << "\n";
+public:
+    ~Tracer()
+    {
+        flush();
     }
 
-    void log(const std::string& startMsg, const float cost, const std::string& endMsg) 
+    void logMsg(const char* msg)
     {
-        if (!debug)
-        {
-            return;
-        }
+        buffer << msg << "\n";
+        spill();
+    }
 
-        if (cost < INF) 
+    void log(const char* startMsg, const float cost, const char* endMsg)
+    {
+        if (cost < INF)
         {
-            std::cout << startMsg << cost << endMsg;
+            buffer << startMsg << cost << endMsg;
         }
-        else 
+        else
         {
-            std::cout << startMsg << "INF" << endMsg;
+            buffer << startMsg << "INF" << endMsg;
         }
+        spill();
     }
 
-    void logPath(std::vector<int> path)
+    void logPath(const std::vector<int>& path)
     {
-        if (!debug)
+        for (auto& element : path)
         {
-            return;
+            buffer << element << " ";
         }
+        buffer << "\n";
+        spill();
+    }
 
-        for(auto& element : path)
-        {
-            std::cout << element << " ";
-        }
-        std::cout << "\n";
+    // writing the collected logs on screen, so that they go before the answer
+    void flush()
+    {
+        std::cout << buffer.str();
+        buffer.str("");
     }
 };
 
+using Debugger = Tracer<DEBUG>;
+
 class Solver
 {
 private:
@@ -102,8 +132,8 @@ public:
             // cheapest arcs going in and out of path (which don't create a loop prematurely)
             std::pair<double, double> pathCheapestInOut; 
 
-            // info about best candidate
-            int bestCity, index;
+            // info about best candidate, the first one stays if every arc is missing and the tour costs INF
+            int bestCity = citiesToVisit[0], index = 0;
 
             // best lower estimation of the rest of the trip
             double bestCandidateCost = INF;
@@ -230,6 +260,7 @@ public:
         findSolution();
 
         dbg.logMsg("\nEND");
+        dbg.flush();
 
         // path wasn't found (no hamiltonian cycle)
         if (totalCost >= INF)
@@ -240,6 +271,7 @@ public:
 
         // print results
         dbg.logMsg("\nANSWER:\n");
+        dbg.flush();
 
         std::cout << totalCost << "\n";
         for (auto& element : path)